@@ -63,6 +63,7 @@ public:
 
 private:
     pandora::StatusCode Run();
+    pandora::StatusCode Reset();
     pandora::StatusCode ReadSettings(const pandora::TiXmlHandle xmlHandle);
 
     /**
@@ -71,6 +72,22 @@ private:
      */
     void SetEventRunMCIdInfo();
 
+    /**
+     *  @brief  Open the event ROOT file and set up its tree for reading the event, run numbers, trigger timing and MC Ids
+     */
+    void OpenEventFile();
+
+    /**
+     *  @brief  Close the event ROOT file, if it is open
+     */
+    void CloseEventFile();
+
+    /**
+     *  @brief  Start the current job of a persistent server, which has its own input event file and analysis output file. The job
+     *          input file replaces the EventFileName setting
+     */
+    void StartServerJob();
+
     /**
      *  @brief  Create the analysis output using hierarchy tools
      *
@@ -100,7 +117,9 @@ private:
     const RecoMCMatch GetRecoMCMatch(const LArHierarchyHelper::RecoHierarchy::Node *pRecoNode,
         const LArHierarchyHelper::MatchInfo &matchInfo, pandora::MCParticleList &rootMCParticles) const;
 
-    int m_count;                       ///< The number of times the Run() function has been called
+    int m_count;                       ///< The number of input events seen, less one, counting the sub-events of a spill once
+    unsigned int m_jobNumber;          ///< The number of the server job being processed, or 0 if not running as a server
+    unsigned int m_savedJobNumber;     ///< The number of the last server job whose analysis output has been saved
     int m_event;                       ///< The actual event number
     int m_run;                         ///< The run number
     int m_subRun;                      ///< The subrun number
@@ -108,9 +127,15 @@ private:
     int m_startTime;                   ///< The event trigger start time (ticks = 0.1 usec)
     int m_endTime;                     ///< The event trigger end time (ticks = 0.1 usec)
     int m_triggers;                    ///< The event trigger flag
+    float m_voxelWidth;                ///< The voxel width (hit cell size) used for the event
+    int m_overBudget;                  ///< Whether the event ran out of its time budget, so has partial results
+    int m_nSkippedSlices;              ///< The number of slices not reconstructed because the event ran out of its time budget
+    int m_subEvent;                    ///< The index of the sub-event in its spill, or -1 if the whole spill is one event
+    float m_subEventStartTime;         ///< The time of the earliest space point of the sub-event
+    float m_subEventEndTime;           ///< The time of the latest space point of the sub-event
     std::vector<long> *m_mcIDs;        ///< The vector of unique MC particle IDs for the event
     std::vector<long> *m_mcLocalIDs;   ///< The vector of local MC particle IDs for the event
-    std::string m_eventFileName;       ///< Name of the ROOT TFile containing the event numbers
+    std::string m_eventFileName;       ///< Name of the ROOT TFile containing the event numbers, replaced by each server job input
     std::string m_eventTreeName;       ///< Name of the ROOT TTree containing the event numbers
     std::string m_eventLeafName;       ///< Name of the event number leaf/variable
     std::string m_runLeafName;         ///< Name of the run number leaf/variable
@@ -11,6 +11,12 @@
 #include "LArRay.h"
 #include "Pandora/PandoraInputTypes.h"
 
+#include <vector>
+
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+
 namespace lar_nd_reco
 {
 
@@ -36,6 +42,17 @@ public:
      */
     bool Intersect(const LArRay &ray, double &t0, double &t1) const;
 
+    /**
+     *  @brief  Find box intersection lengths for a batch of rays. Uses AVX lanes when the compiler targets them (e.g. -mavx
+     *          or -march=native), otherwise falls back to the scalar slab test; both give bit-identical results to Intersect
+     *
+     *  @param  rays The structure-of-arrays ray batch
+     *  @param  t0 To receive the first intersection lengths (only meaningful where isHit is set)
+     *  @param  t1 To receive the second intersection lengths (only meaningful where isHit is set)
+     *  @param  isHit To receive whether each ray intersects the box (1) or not (0)
+     */
+    void Intersect(const LArRayBatch &rays, std::vector<double> &t0, std::vector<double> &t1, std::vector<int> &isHit) const;
+
     /**
      *  @brief  Check if the given point is inside the box
      *
@@ -47,6 +64,27 @@ public:
 
     pandora::CartesianVector m_bottom; ///< The bottom corner of the box
     pandora::CartesianVector m_top;    ///< The top corner of the box
+
+private:
+    /**
+     *  @brief  Scalar slab test shared by the single ray and batched intersections
+     *
+     *  @param  x The ray starting x coordinate
+     *  @param  y The ray starting y coordinate
+     *  @param  z The ray starting z coordinate
+     *  @param  invDirX The reciprocal ray direction x component
+     *  @param  invDirY The reciprocal ray direction y component
+     *  @param  invDirZ The reciprocal ray direction z component
+     *  @param  signX The sign of the reciprocal ray direction x component
+     *  @param  signY The sign of the reciprocal ray direction y component
+     *  @param  signZ The sign of the reciprocal ray direction z component
+     *  @param  t0 The first intersection length along ray from its starting point
+     *  @param  t1 The second intersection length along ray from its starting point
+     *
+     *  @return Success/failure of finding both intersection lengths
+     */
+    bool IntersectSlabs(const double x, const double y, const double z, const double invDirX, const double invDirY, const double invDirZ,
+        const int signX, const int signY, const int signZ, double &t0, double &t1) const;
 };
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -57,7 +95,16 @@ inline LArBox::LArBox(const pandora::CartesianVector &bottom, const pandora::Car
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-bool LArBox::Intersect(const LArRay &ray, double &t0, double &t1) const
+inline bool LArBox::Intersect(const LArRay &ray, double &t0, double &t1) const
+{
+    return this->IntersectSlabs(ray.m_origin.GetX(), ray.m_origin.GetY(), ray.m_origin.GetZ(), ray.m_invDir.GetX(), ray.m_invDir.GetY(),
+        ray.m_invDir.GetZ(), ray.m_sign[0], ray.m_sign[1], ray.m_sign[2], t0, t1);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline bool LArBox::IntersectSlabs(const double x, const double y, const double z, const double invDirX, const double invDirY,
+    const double invDirZ, const int signX, const int signY, const int signZ, double &t0, double &t1) const
 {
     // Brian Smits ray-box intersection algorithm with improvements from Amy Williams et al. Code based on
     // https://github.com/chenel/larcv2/tree/edepsim-formattruth/larcv/app/Supera/Voxelize.cxx (MIT license)
@@ -65,15 +112,9 @@ bool LArBox::Intersect(const LArRay &ray, double &t0, double &t1) const
     // https://doi.org/10.1145/1198555.1198748 and ii) "Efficiency Issues for Ray Tracing", Brian Smits (1998):
     // https://doi.org/10.1080/10867651.1998.10487488. The Smits-Williams GPLv3 licensed code is available from:
     // https://www.scratchapixel.com/lessons/3d-basic-rendering/minimal-ray-tracer-rendering-simple-shapes/ray-box-intersection
-    const double x(ray.m_origin.GetX());
-    const double y(ray.m_origin.GetY());
-
-    const double invDirX(ray.m_invDir.GetX());
-    const double invDirY(ray.m_invDir.GetY());
-
     double tMin(0.0), tMax(0.0), tyMin(0.0), tyMax(0.0), tzMin(0.0), tzMax(0.0);
 
-    if (ray.m_sign[0] == 0)
+    if (signX == 0)
     {
         tMin = (m_bottom.GetX() - x) * invDirX;
         tMax = (m_top.GetX() - x) * invDirX;
@@ -84,7 +125,7 @@ bool LArBox::Intersect(const LArRay &ray, double &t0, double &t1) const
         tMax = (m_bottom.GetX() - x) * invDirX;
     }
 
-    if (ray.m_sign[1] == 0)
+    if (signY == 0)
     {
         tyMin = (m_bottom.GetY() - y) * invDirY;
         tyMax = (m_top.GetY() - y) * invDirY;
@@ -104,9 +145,7 @@ bool LArBox::Intersect(const LArRay &ray, double &t0, double &t1) const
     if (tyMax < tMax)
         tMax = tyMax;
 
-    const double z(ray.m_origin.GetZ());
-    const double invDirZ(ray.m_invDir.GetZ());
-    if (ray.m_sign[2] == 0)
+    if (signZ == 0)
     {
         tzMin = (m_bottom.GetZ() - z) * invDirZ;
         tzMax = (m_top.GetZ() - z) * invDirZ;
@@ -134,7 +173,73 @@ bool LArBox::Intersect(const LArRay &ray, double &t0, double &t1) const
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-bool LArBox::Inside(const pandora::CartesianVector &point) const
+inline void LArBox::Intersect(const LArRayBatch &rays, std::vector<double> &t0, std::vector<double> &t1, std::vector<int> &isHit) const
+{
+    const std::size_t nRays(rays.GetSize());
+    t0.assign(nRays, 0.0);
+    t1.assign(nRays, 0.0);
+    isHit.assign(nRays, 0);
+
+    std::size_t i(0);
+
+#ifdef __AVX__
+    // Same operations as the scalar slab test, four rays at a time. The slab bounds are chosen per lane from the signs, and
+    // max(a, b)/min(a, b) return b for ties, matching the scalar "only replace if strictly greater/smaller" updates
+    const __m256d zero(_mm256_setzero_pd());
+    const __m256d botX(_mm256_set1_pd(m_bottom.GetX())), botY(_mm256_set1_pd(m_bottom.GetY())), botZ(_mm256_set1_pd(m_bottom.GetZ()));
+    const __m256d topX(_mm256_set1_pd(m_top.GetX())), topY(_mm256_set1_pd(m_top.GetY())), topZ(_mm256_set1_pd(m_top.GetZ()));
+
+    // All bits set in the lanes where the reciprocal direction component is negative
+    auto signMask = [&zero](const std::vector<int> &signs, const std::size_t index) -> __m256d {
+        const __m128i lanes(_mm_loadu_si128(reinterpret_cast<const __m128i *>(&signs[index])));
+        return _mm256_cmp_pd(_mm256_cvtepi32_pd(lanes), zero, _CMP_NEQ_OQ);
+    };
+
+    for (; i + 4 <= nRays; i += 4)
+    {
+        const __m256d x(_mm256_loadu_pd(&rays.m_originX[i])), y(_mm256_loadu_pd(&rays.m_originY[i])), z(_mm256_loadu_pd(&rays.m_originZ[i]));
+        const __m256d invDirX(_mm256_loadu_pd(&rays.m_invDirX[i]));
+        const __m256d invDirY(_mm256_loadu_pd(&rays.m_invDirY[i]));
+        const __m256d invDirZ(_mm256_loadu_pd(&rays.m_invDirZ[i]));
+
+        const __m256d negX(signMask(rays.m_signX, i)), negY(signMask(rays.m_signY, i)), negZ(signMask(rays.m_signZ, i));
+
+        __m256d tMin(_mm256_mul_pd(_mm256_sub_pd(_mm256_blendv_pd(botX, topX, negX), x), invDirX));
+        __m256d tMax(_mm256_mul_pd(_mm256_sub_pd(_mm256_blendv_pd(topX, botX, negX), x), invDirX));
+        const __m256d tyMin(_mm256_mul_pd(_mm256_sub_pd(_mm256_blendv_pd(botY, topY, negY), y), invDirY));
+        const __m256d tyMax(_mm256_mul_pd(_mm256_sub_pd(_mm256_blendv_pd(topY, botY, negY), y), invDirY));
+
+        __m256d miss(_mm256_or_pd(_mm256_cmp_pd(tMin, tyMax, _CMP_GT_OQ), _mm256_cmp_pd(tyMin, tMax, _CMP_GT_OQ)));
+        tMin = _mm256_max_pd(tyMin, tMin);
+        tMax = _mm256_min_pd(tyMax, tMax);
+
+        const __m256d tzMin(_mm256_mul_pd(_mm256_sub_pd(_mm256_blendv_pd(botZ, topZ, negZ), z), invDirZ));
+        const __m256d tzMax(_mm256_mul_pd(_mm256_sub_pd(_mm256_blendv_pd(topZ, botZ, negZ), z), invDirZ));
+
+        miss = _mm256_or_pd(miss, _mm256_or_pd(_mm256_cmp_pd(tMin, tzMax, _CMP_GT_OQ), _mm256_cmp_pd(tzMin, tMax, _CMP_GT_OQ)));
+        tMin = _mm256_max_pd(tzMin, tMin);
+        tMax = _mm256_min_pd(tzMax, tMax);
+
+        // Misses are left as zero, as in the scalar path
+        _mm256_storeu_pd(&t0[i], _mm256_andnot_pd(miss, tMin));
+        _mm256_storeu_pd(&t1[i], _mm256_andnot_pd(miss, tMax));
+
+        const int missBits(_mm256_movemask_pd(miss));
+        for (int lane = 0; lane < 4; ++lane)
+            isHit[i + lane] = ((missBits >> lane) & 1) ? 0 : 1;
+    }
+#endif
+
+    for (; i < nRays; ++i)
+    {
+        isHit[i] = this->IntersectSlabs(rays.m_originX[i], rays.m_originY[i], rays.m_originZ[i], rays.m_invDirX[i], rays.m_invDirY[i],
+            rays.m_invDirZ[i], rays.m_signX[i], rays.m_signY[i], rays.m_signZ[i], t0[i], t1[i]) ? 1 : 0;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline bool LArBox::Inside(const pandora::CartesianVector &point) const
 {
     const float x = point.GetX();
     const float y = point.GetY();
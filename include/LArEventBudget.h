@@ -0,0 +1,67 @@
+/**
+ *  @file   include/LArEventBudget.h
+ *
+ *  @brief  Header file for the time budget status of the current event.
+ *
+ *  $Log: $
+ */
+#ifndef LAR_EVENT_BUDGET_H
+#define LAR_EVENT_BUDGET_H 1
+
+namespace lar_content
+{
+
+/**
+ *  @brief  Whether the reconstruction of the current event ran out of its time budget, so that some stages were skipped or
+ *          simplified. Set by the master algorithm and read by the output algorithms, which flag the partial event
+ */
+class LArEventBudget
+{
+public:
+    /**
+     *  @brief  Get the time budget status of the current event
+     *
+     *  @return the time budget status
+     */
+    static LArEventBudget &Get();
+
+    /**
+     *  @brief  Reset the status at the start of an event
+     */
+    void Clear();
+
+    bool m_isOverBudget;           ///< Whether the event ran out of its time budget
+    unsigned int m_nSkippedSlices; ///< The number of slices whose neutrino and cosmic-ray reconstruction was skipped
+
+private:
+    /**
+     *  @brief  Default constructor
+     */
+    LArEventBudget();
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArEventBudget &LArEventBudget::Get()
+{
+    static LArEventBudget eventBudget;
+    return eventBudget;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArEventBudget::Clear()
+{
+    m_isOverBudget = false;
+    m_nSkippedSlices = 0;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArEventBudget::LArEventBudget() : m_isOverBudget(false), m_nSkippedSlices(0)
+{
+}
+
+} // namespace lar_content
+
+#endif // #ifndef LAR_EVENT_BUDGET_H
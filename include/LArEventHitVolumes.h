@@ -0,0 +1,125 @@
+/**
+ *  @file   include/LArEventHitVolumes.h
+ *
+ *  @brief  Header file for the LArTPC volumes of the calo hits of the current event.
+ *
+ *  $Log: $
+ */
+#ifndef LAR_EVENT_HIT_VOLUMES_H
+#define LAR_EVENT_HIT_VOLUMES_H 1
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace lar_content
+{
+
+/**
+ *  @brief  The LArTPC volume id and x position of each calo hit of the current event, recorded by the application as it creates
+ *          the hits and indexed by their parent address, which the application sets to a hit counter. This lets the master
+ *          algorithm partition the hits by volume without inspecting them
+ */
+class LArEventHitVolumes
+{
+public:
+    /**
+     *  @brief  Get the hit volumes of the current event
+     *
+     *  @return the hit volumes
+     */
+    static LArEventHitVolumes &Get();
+
+    /**
+     *  @brief  Forget the hits of the previous event
+     */
+    void Clear();
+
+    /**
+     *  @brief  Record a calo hit. Hits whose parent address is not a small hit counter are not recorded
+     *
+     *  @param  pParentAddress the parent address of the calo hit
+     *  @param  volumeId the LArTPC volume id of the calo hit
+     *  @param  x the x position of the calo hit
+     */
+    void AddHit(const void *const pParentAddress, const unsigned int volumeId, const float x);
+
+    /**
+     *  @brief  Get the index of a recorded calo hit
+     *
+     *  @param  pParentAddress the parent address of the calo hit
+     *  @param  hitIndex to receive the index of the calo hit in the recorded vectors
+     *
+     *  @return whether the calo hit was recorded
+     */
+    bool GetHitIndex(const void *const pParentAddress, std::size_t &hitIndex) const;
+
+    std::vector<unsigned int> m_volumeIds;   ///< The LArTPC volume id of each calo hit
+    std::vector<float> m_positionsX;         ///< The x position of each calo hit
+    std::vector<unsigned char> m_isRecorded; ///< Whether a calo hit has been recorded at each index
+
+private:
+    /**
+     *  @brief  Default constructor
+     */
+    LArEventHitVolumes();
+
+    static constexpr std::size_t m_maxHits{1 << 24}; ///< The max number of calo hits that can be recorded for an event
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArEventHitVolumes &LArEventHitVolumes::Get()
+{
+    static LArEventHitVolumes eventHitVolumes;
+    return eventHitVolumes;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArEventHitVolumes::LArEventHitVolumes()
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArEventHitVolumes::Clear()
+{
+    // Keep the capacity for the next event
+    m_volumeIds.clear();
+    m_positionsX.clear();
+    m_isRecorded.clear();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArEventHitVolumes::AddHit(const void *const pParentAddress, const unsigned int volumeId, const float x)
+{
+    const std::uintptr_t hitIndex(reinterpret_cast<std::uintptr_t>(pParentAddress));
+
+    if (hitIndex >= m_maxHits)
+        return;
+
+    if (hitIndex >= m_isRecorded.size())
+    {
+        m_volumeIds.resize(hitIndex + 1, 0);
+        m_positionsX.resize(hitIndex + 1, 0.f);
+        m_isRecorded.resize(hitIndex + 1, 0);
+    }
+
+    m_volumeIds[hitIndex] = volumeId;
+    m_positionsX[hitIndex] = x;
+    m_isRecorded[hitIndex] = 1;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline bool LArEventHitVolumes::GetHitIndex(const void *const pParentAddress, std::size_t &hitIndex) const
+{
+    hitIndex = reinterpret_cast<std::uintptr_t>(pParentAddress);
+    return (hitIndex < m_isRecorded.size()) && m_isRecorded[hitIndex];
+}
+
+} // namespace lar_content
+
+#endif // #ifndef LAR_EVENT_HIT_VOLUMES_H
@@ -0,0 +1,130 @@
+/**
+ *  @file   include/LArEventHitVoxels.h
+ *
+ *  @brief  Header file for the original voxels of the 3D calo hits of the current event.
+ *
+ *  $Log: $
+ */
+#ifndef LAR_EVENT_HIT_VOXELS_H
+#define LAR_EVENT_HIT_VOXELS_H 1
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace lar_content
+{
+
+/**
+ *  @brief  The ids of the original voxels represented by each 3D calo hit of the current event, recorded by the application as
+ *          it creates the hits and indexed by their parent address, which the application sets to a hit counter. A hit made from
+ *          a compressed or coarsened voxel lists all the voxels it replaced, so the analysis output can map it back to them
+ */
+class LArEventHitVoxels
+{
+public:
+    /**
+     *  @brief  Get the hit voxels of the current event
+     *
+     *  @return the hit voxels
+     */
+    static LArEventHitVoxels &Get();
+
+    /**
+     *  @brief  Forget the hits of the previous event
+     */
+    void Clear();
+
+    /**
+     *  @brief  Record the original voxels of a 3D calo hit. Hits whose parent address is not a small hit counter are not recorded
+     *
+     *  @param  pParentAddress the parent address of the calo hit
+     *  @param  voxelIDs the ids of the original voxels represented by the calo hit
+     */
+    void AddHit(const void *const pParentAddress, const std::vector<long> &voxelIDs);
+
+    /**
+     *  @brief  Get the original voxels of a recorded 3D calo hit
+     *
+     *  @param  pParentAddress the parent address of the calo hit
+     *  @param  voxelIDs to receive the ids of the original voxels represented by the calo hit
+     *
+     *  @return whether the calo hit was recorded
+     */
+    bool GetVoxelIDs(const void *const pParentAddress, std::vector<long> &voxelIDs) const;
+
+private:
+    /**
+     *  @brief  Default constructor
+     */
+    LArEventHitVoxels();
+
+    std::vector<std::size_t> m_firstVoxelIndices; ///< The index of the first voxel id of each calo hit in m_voxelIDs
+    std::vector<unsigned int> m_nVoxels;          ///< The number of voxel ids of each calo hit (0 = not recorded)
+    std::vector<long> m_voxelIDs;                 ///< The voxel ids of all recorded calo hits, in the order they were recorded
+
+    static constexpr std::size_t m_maxHits{1 << 24}; ///< The max number of calo hits that can be recorded for an event
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArEventHitVoxels &LArEventHitVoxels::Get()
+{
+    static LArEventHitVoxels eventHitVoxels;
+    return eventHitVoxels;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArEventHitVoxels::LArEventHitVoxels()
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArEventHitVoxels::Clear()
+{
+    // Keep the capacity for the next event
+    m_firstVoxelIndices.clear();
+    m_nVoxels.clear();
+    m_voxelIDs.clear();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArEventHitVoxels::AddHit(const void *const pParentAddress, const std::vector<long> &voxelIDs)
+{
+    const std::uintptr_t hitIndex(reinterpret_cast<std::uintptr_t>(pParentAddress));
+
+    if ((hitIndex >= m_maxHits) || voxelIDs.empty())
+        return;
+
+    if (hitIndex >= m_nVoxels.size())
+    {
+        m_firstVoxelIndices.resize(hitIndex + 1, 0);
+        m_nVoxels.resize(hitIndex + 1, 0);
+    }
+
+    m_firstVoxelIndices[hitIndex] = m_voxelIDs.size();
+    m_nVoxels[hitIndex] = voxelIDs.size();
+    m_voxelIDs.insert(m_voxelIDs.end(), voxelIDs.begin(), voxelIDs.end());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline bool LArEventHitVoxels::GetVoxelIDs(const void *const pParentAddress, std::vector<long> &voxelIDs) const
+{
+    const std::uintptr_t hitIndex(reinterpret_cast<std::uintptr_t>(pParentAddress));
+    voxelIDs.clear();
+
+    if ((hitIndex >= m_nVoxels.size()) || (0 == m_nVoxels[hitIndex]))
+        return false;
+
+    const std::vector<long>::const_iterator firstIter(m_voxelIDs.begin() + m_firstVoxelIndices[hitIndex]);
+    voxelIDs.assign(firstIter, firstIter + m_nVoxels[hitIndex]);
+    return true;
+}
+
+} // namespace lar_content
+
+#endif // #ifndef LAR_EVENT_HIT_VOXELS_H
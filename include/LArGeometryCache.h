@@ -0,0 +1,235 @@
+/**
+ *  @file   LArReco/include/LArGeometryCache.h
+ *
+ *  @brief  Header file for the cache of the resolved TPC volumes of the geometry
+ *
+ *  $Log: $
+ */
+#ifndef PANDORA_LAR_GEOMETRY_CACHE_H
+#define PANDORA_LAR_GEOMETRY_CACHE_H 1
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <initializer_list>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace lar_nd_reco
+{
+
+/**
+ *  @brief  The resolved box of a TPC volume, in global coordinates (cm)
+ */
+class LArCachedTPC
+{
+public:
+    int m_tpcID;         ///< The TPC number, whose module number is m_tpcID / 2
+    double m_centreX;    ///< The x coordinate of the TPC centre
+    double m_centreY;    ///< The y coordinate of the TPC centre
+    double m_centreZ;    ///< The z coordinate of the TPC centre
+    double m_halfWidthX; ///< The half width of the TPC along x
+    double m_halfWidthY; ///< The half width of the TPC along y
+    double m_halfWidthZ; ///< The half width of the TPC along z
+};
+
+typedef std::vector<LArCachedTPC> LArCachedTPCList;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Binary cache of the TPC volumes found in a geometry file, so that later jobs do not need to import and search
+ *          the TGeoManager. The cache stores a format version and a checksum of the source geometry file and of the options
+ *          used to resolve the TPCs, and is only used if both match
+ */
+class LArGeometryCache
+{
+public:
+    /**
+     *  @brief  Constructor
+     *
+     *  @param  checksum The checksum of the source geometry and the options used to resolve the TPCs
+     */
+    LArGeometryCache(const std::uint64_t checksum);
+
+    /**
+     *  @brief  Get the checksum of a geometry file and the options used to resolve its TPCs
+     *
+     *  @param  geomFileName The geometry file name
+     *  @param  options The description of the options used to resolve the TPCs
+     *  @param  checksum To receive the checksum
+     *
+     *  @return Whether the geometry file could be read
+     */
+    static bool GetChecksum(const std::string &geomFileName, const std::string &options, std::uint64_t &checksum);
+
+    /**
+     *  @brief  Read the TPCs from a cache file, replacing any existing ones
+     *
+     *  @param  fileName The cache file name
+     *
+     *  @return Whether the file exists and has the expected version and checksum
+     */
+    bool Read(const std::string &fileName);
+
+    /**
+     *  @brief  Write the TPCs to a cache file
+     *
+     *  @param  fileName The cache file name
+     *
+     *  @return Whether the file was written
+     */
+    bool Write(const std::string &fileName) const;
+
+    /**
+     *  @brief  Add a TPC
+     *
+     *  @param  tpc The TPC
+     */
+    void AddTPC(const LArCachedTPC &tpc);
+
+    /**
+     *  @brief  Get the TPCs
+     *
+     *  @return The TPCs, in order of creation
+     */
+    const LArCachedTPCList &GetTPCs() const;
+
+private:
+    /**
+     *  @brief  Update a 64 bit FNV-1a hash with a block of bytes
+     *
+     *  @param  pData The address of the bytes
+     *  @param  nBytes The number of bytes
+     *  @param  hash The hash to update
+     */
+    static void UpdateHash(const char *const pData, const std::size_t nBytes, std::uint64_t &hash);
+
+    static constexpr char m_magic[8] = {'L', 'A', 'R', 'N', 'D', 'G', 'E', 'O'}; ///< The identifier at the start of a cache file
+    static constexpr std::uint32_t m_version{1};                               ///< The version of the cache file format
+
+    std::uint64_t m_checksum; ///< The checksum of the source geometry and the options used to resolve the TPCs
+    LArCachedTPCList m_tpcs;  ///< The TPCs
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArGeometryCache::LArGeometryCache(const std::uint64_t checksum) : m_checksum(checksum)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline bool LArGeometryCache::GetChecksum(const std::string &geomFileName, const std::string &options, std::uint64_t &checksum)
+{
+    std::ifstream geomFile(geomFileName, std::ios::binary);
+    if (!geomFile)
+        return false;
+
+    checksum = 14695981039346656037ULL;
+    LArGeometryCache::UpdateHash(options.data(), options.size(), checksum);
+
+    std::vector<char> buffer(1 << 20);
+    while (geomFile)
+    {
+        geomFile.read(buffer.data(), buffer.size());
+        LArGeometryCache::UpdateHash(buffer.data(), static_cast<std::size_t>(geomFile.gcount()), checksum);
+    }
+
+    return geomFile.eof();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline bool LArGeometryCache::Read(const std::string &fileName)
+{
+    std::ifstream cacheFile(fileName, std::ios::binary);
+    if (!cacheFile)
+        return false;
+
+    char magic[sizeof(m_magic)];
+    std::uint32_t version(0);
+    std::uint64_t checksum(0);
+    std::uint32_t nTPCs(0);
+    cacheFile.read(magic, sizeof(magic));
+    cacheFile.read(reinterpret_cast<char *>(&version), sizeof(version));
+    cacheFile.read(reinterpret_cast<char *>(&checksum), sizeof(checksum));
+    cacheFile.read(reinterpret_cast<char *>(&nTPCs), sizeof(nTPCs));
+
+    if (!cacheFile || !std::equal(magic, magic + sizeof(magic), m_magic) || version != m_version || checksum != m_checksum)
+        return false;
+
+    LArCachedTPCList tpcs(nTPCs);
+    for (LArCachedTPC &tpc : tpcs)
+    {
+        std::int32_t tpcID(0);
+        cacheFile.read(reinterpret_cast<char *>(&tpcID), sizeof(tpcID));
+        tpc.m_tpcID = tpcID;
+
+        for (double *pValue : {&tpc.m_centreX, &tpc.m_centreY, &tpc.m_centreZ, &tpc.m_halfWidthX, &tpc.m_halfWidthY, &tpc.m_halfWidthZ})
+            cacheFile.read(reinterpret_cast<char *>(pValue), sizeof(double));
+    }
+
+    if (!cacheFile)
+        return false;
+
+    m_tpcs = std::move(tpcs);
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline bool LArGeometryCache::Write(const std::string &fileName) const
+{
+    std::ofstream cacheFile(fileName, std::ios::binary | std::ios::trunc);
+    if (!cacheFile)
+        return false;
+
+    const std::uint32_t nTPCs(m_tpcs.size());
+    cacheFile.write(m_magic, sizeof(m_magic));
+    cacheFile.write(reinterpret_cast<const char *>(&m_version), sizeof(m_version));
+    cacheFile.write(reinterpret_cast<const char *>(&m_checksum), sizeof(m_checksum));
+    cacheFile.write(reinterpret_cast<const char *>(&nTPCs), sizeof(nTPCs));
+
+    for (const LArCachedTPC &tpc : m_tpcs)
+    {
+        const std::int32_t tpcID(tpc.m_tpcID);
+        cacheFile.write(reinterpret_cast<const char *>(&tpcID), sizeof(tpcID));
+
+        for (const double value : {tpc.m_centreX, tpc.m_centreY, tpc.m_centreZ, tpc.m_halfWidthX, tpc.m_halfWidthY, tpc.m_halfWidthZ})
+            cacheFile.write(reinterpret_cast<const char *>(&value), sizeof(double));
+    }
+
+    return static_cast<bool>(cacheFile.flush());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArGeometryCache::AddTPC(const LArCachedTPC &tpc)
+{
+    m_tpcs.emplace_back(tpc);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline const LArCachedTPCList &LArGeometryCache::GetTPCs() const
+{
+    return m_tpcs;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArGeometryCache::UpdateHash(const char *const pData, const std::size_t nBytes, std::uint64_t &hash)
+{
+    for (std::size_t i = 0; i < nBytes; ++i)
+    {
+        hash ^= static_cast<unsigned char>(pData[i]);
+        hash *= 1099511628211ULL;
+    }
+}
+
+} // namespace lar_nd_reco
+
+#endif
@@ -11,12 +11,15 @@
 #include "LArBox.h"
 #include "Pandora/PandoraInputTypes.h"
 #include <array>
+#include <cstdint>
+#include <vector>
 
 namespace lar_nd_reco
 {
 
 typedef std::array<long, 3> LongBin3Array;
 typedef std::array<long, 4> LongBin4Array;
+typedef std::vector<LongBin4Array> LongBin4ArrayList;
 
 class LArGrid : public LArBox
 {
@@ -27,8 +30,10 @@ public:
      *  @param  bottom The bottom starting corner of the grid (CartesianVector)
      *  @param  top The top end corner of the grid (CartesianVector)
      *  @param  binWidths The regular bin widths stored as a CartesianVector(dx, dy, dz)
+     *  @param  useMortonOrder Whether the total bin is the Z-order (Morton) code of the (x,y,z) bins instead of the row-major index
      */
-    LArGrid(const pandora::CartesianVector &bottom, const pandora::CartesianVector &top, const pandora::CartesianVector &binWidths);
+    LArGrid(const pandora::CartesianVector &bottom, const pandora::CartesianVector &top, const pandora::CartesianVector &binWidths,
+        const bool useMortonOrder = false);
 
     /**
      *  @brief  Get the (x,y,z,total) bin indices for the given point. Need long integers, since total bin can be > 2^31
@@ -39,6 +44,34 @@ public:
      */
     LongBin4Array GetBinIndices(const pandora::CartesianVector &point) const;
 
+    /**
+     *  @brief  Get the total bin for the given x, y and z bins, using the grid bin encoding (row-major or Morton)
+     *
+     *  @param  xBin The x bin index (long integer)
+     *  @param  yBin The y bin index (long integer)
+     *  @param  zBin The z bin index (long integer)
+     *
+     *  @return The total bin long integer index
+     */
+    long GetTotalBin(const long xBin, const long yBin, const long zBin) const;
+
+    /**
+     *  @brief  Get the (x,y,z,total) bin indices for the given total bin, inverting the grid bin encoding
+     *
+     *  @param  totalBin The total bin long integer index
+     *
+     *  @return The array of (x,y,z,total) bin long integer indices
+     */
+    LongBin4Array GetBinIndices(const long totalBin) const;
+
+    /**
+     *  @brief  Get the bin indices of the (up to 26) face, edge and corner neighbours of the given bin that lie inside the grid
+     *
+     *  @param  bins The (x,y,z,total) bins of the central voxel
+     *  @param  neighbours To receive the (x,y,z,total) bins of the neighbouring voxels
+     */
+    void GetNeighbourBinIndices(const LongBin4Array &bins, LongBin4ArrayList &neighbours) const;
+
     /**
      *  @brief  Get the position for the given x, y and z bins
      *
@@ -63,16 +96,97 @@ public:
     pandora::CartesianVector m_top;       ///< The top corner of the box
     pandora::CartesianVector m_binWidths; ///< The bin widths (dx, dy, dz)
     LongBin3Array m_nBins;                ///< The (x,y,z) bin indices (long integers)
+    bool m_useMortonOrder;                ///< Whether the total bin is the Z-order (Morton) code of the (x,y,z) bins
 };
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-inline LArGrid::LArGrid(const pandora::CartesianVector &bottom, const pandora::CartesianVector &top, const pandora::CartesianVector &binWidths) :
+const long MaxMortonBins{1L << 21}; ///< The number of bins per axis that fit in a 63-bit Morton code
+
+/**
+ *  @brief  Insert two zero bits between each of the lowest 21 bits of the given value
+ *
+ *  @param  value The value to spread
+ *
+ *  @return The spread bits
+ */
+inline std::uint64_t SpreadMortonBits(const std::uint64_t value)
+{
+    std::uint64_t bits(value & 0x1fffffULL);
+    bits = (bits | (bits << 32)) & 0x1f00000000ffffULL;
+    bits = (bits | (bits << 16)) & 0x1f0000ff0000ffULL;
+    bits = (bits | (bits << 8)) & 0x100f00f00f00f00fULL;
+    bits = (bits | (bits << 4)) & 0x10c30c30c30c30c3ULL;
+    bits = (bits | (bits << 2)) & 0x1249249249249249ULL;
+    return bits;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Gather every third bit of the given value into its lowest 21 bits (the inverse of SpreadMortonBits)
+ *
+ *  @param  value The value to compact
+ *
+ *  @return The compacted bits
+ */
+inline std::uint64_t CompactMortonBits(const std::uint64_t value)
+{
+    std::uint64_t bits(value & 0x1249249249249249ULL);
+    bits = (bits | (bits >> 2)) & 0x10c30c30c30c30c3ULL;
+    bits = (bits | (bits >> 4)) & 0x100f00f00f00f00fULL;
+    bits = (bits | (bits >> 8)) & 0x1f0000ff0000ffULL;
+    bits = (bits | (bits >> 16)) & 0x1f00000000ffffULL;
+    bits = (bits | (bits >> 32)) & 0x1fffffULL;
+    return bits;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Interleave the bits of the x, y and z bins into a Z-order (Morton) code, so that nearby voxels in all three
+ *          directions get nearby total bin numbers. Each bin index must be smaller than MaxMortonBins
+ *
+ *  @param  xBin The x bin index
+ *  @param  yBin The y bin index
+ *  @param  zBin The z bin index
+ *
+ *  @return The Morton code, where bit 3n + {0,1,2} holds bit n of the {x,y,z} bin
+ */
+inline long EncodeMorton(const long xBin, const long yBin, const long zBin)
+{
+    const std::uint64_t code(SpreadMortonBits(static_cast<std::uint64_t>(xBin)) | (SpreadMortonBits(static_cast<std::uint64_t>(yBin)) << 1) |
+        (SpreadMortonBits(static_cast<std::uint64_t>(zBin)) << 2));
+    return static_cast<long>(code);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Recover the x, y and z bins from a Z-order (Morton) code
+ *
+ *  @param  mortonCode The Morton code
+ *
+ *  @return The (x,y,z) bin indices
+ */
+inline LongBin3Array DecodeMorton(const long mortonCode)
+{
+    const std::uint64_t code(static_cast<std::uint64_t>(mortonCode));
+    const LongBin3Array bins = {static_cast<long>(CompactMortonBits(code)), static_cast<long>(CompactMortonBits(code >> 1)),
+        static_cast<long>(CompactMortonBits(code >> 2))};
+    return bins;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArGrid::LArGrid(const pandora::CartesianVector &bottom, const pandora::CartesianVector &top,
+    const pandora::CartesianVector &binWidths, const bool useMortonOrder) :
     LArBox(bottom, top),
     m_bottom(bottom),
     m_top(top),
     m_binWidths(binWidths),
-    m_nBins({0, 0, 0})
+    m_nBins({0, 0, 0}),
+    m_useMortonOrder(useMortonOrder)
 {
     if (binWidths.GetX() <= 0 || binWidths.GetY() <= 0 || binWidths.GetZ() <= 0)
         throw pandora::StatusCodeException(pandora::STATUS_CODE_OUT_OF_RANGE);
@@ -81,6 +195,9 @@ inline LArGrid::LArGrid(const pandora::CartesianVector &bottom, const pandora::C
     const long NyBins = static_cast<long>((top.GetY() - bottom.GetY()) / binWidths.GetY());
     const long NzBins = static_cast<long>((top.GetZ() - bottom.GetZ()) / binWidths.GetZ());
     m_nBins = {NxBins, NyBins, NzBins};
+
+    if (m_useMortonOrder && (NxBins > MaxMortonBins || NyBins > MaxMortonBins || NzBins > MaxMortonBins))
+        throw pandora::StatusCodeException(pandora::STATUS_CODE_OUT_OF_RANGE);
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -109,7 +226,7 @@ inline LongBin4Array LArGrid::GetBinIndices(const pandora::CartesianVector &poin
     const long yBin = GetBinIndex(point.GetY(), m_bottom.GetY(), m_binWidths.GetY(), m_nBins[1]);
     const long zBin = GetBinIndex(point.GetZ(), m_bottom.GetZ(), m_binWidths.GetZ(), m_nBins[2]);
 
-    const long totBin = (zBin * m_nBins[1] + yBin) * m_nBins[0] + xBin;
+    const long totBin = this->GetTotalBin(xBin, yBin, zBin);
 
     LongBin4Array binIndices = {xBin, yBin, zBin, totBin};
     return binIndices;
@@ -117,6 +234,67 @@ inline LongBin4Array LArGrid::GetBinIndices(const pandora::CartesianVector &poin
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+inline long LArGrid::GetTotalBin(const long xBin, const long yBin, const long zBin) const
+{
+    if (m_useMortonOrder)
+        return EncodeMorton(xBin, yBin, zBin);
+
+    return (zBin * m_nBins[1] + yBin) * m_nBins[0] + xBin;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LongBin4Array LArGrid::GetBinIndices(const long totalBin) const
+{
+    if (m_useMortonOrder)
+    {
+        const LongBin3Array bins = DecodeMorton(totalBin);
+        const LongBin4Array binIndices = {bins[0], bins[1], bins[2], totalBin};
+        return binIndices;
+    }
+
+    const long xBin = totalBin % m_nBins[0];
+    const long yBin = (totalBin / m_nBins[0]) % m_nBins[1];
+    const long zBin = totalBin / (m_nBins[0] * m_nBins[1]);
+
+    const LongBin4Array binIndices = {xBin, yBin, zBin, totalBin};
+    return binIndices;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArGrid::GetNeighbourBinIndices(const LongBin4Array &bins, LongBin4ArrayList &neighbours) const
+{
+    neighbours.clear();
+    neighbours.reserve(26);
+
+    for (long dz = -1; dz <= 1; ++dz)
+    {
+        const long zBin = bins[2] + dz;
+        if (zBin < 0 || zBin >= m_nBins[2])
+            continue;
+
+        for (long dy = -1; dy <= 1; ++dy)
+        {
+            const long yBin = bins[1] + dy;
+            if (yBin < 0 || yBin >= m_nBins[1])
+                continue;
+
+            for (long dx = -1; dx <= 1; ++dx)
+            {
+                const long xBin = bins[0] + dx;
+                if (xBin < 0 || xBin >= m_nBins[0] || (dx == 0 && dy == 0 && dz == 0))
+                    continue;
+
+                const LongBin4Array neighbour = {xBin, yBin, zBin, this->GetTotalBin(xBin, yBin, zBin)};
+                neighbours.emplace_back(neighbour);
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 inline pandora::CartesianVector LArGrid::GetPoint(const long xBin, const long yBin, const long zBin) const
 {
     const float x = m_bottom.GetX() + xBin * m_binWidths.GetX();
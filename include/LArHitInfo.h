@@ -10,6 +10,8 @@
 
 #include "Pandora/PandoraInputTypes.h"
 
+#include <vector>
+
 namespace lar_nd_reco
 {
 
@@ -40,6 +42,9 @@ inline LArHitInfo::LArHitInfo(const pandora::CartesianVector &start, const pando
     m_start(start * lengthScale), m_stop(stop * lengthScale), m_energy(energy * energyScale), m_trackID(trackID)
 {
 }
+
+typedef std::vector<LArHitInfo> LArHitInfoList;
+
 } // namespace lar_nd_reco
 
 #endif
@@ -10,6 +10,13 @@
 
 #include "Pandora/PandoraInputTypes.h"
 
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <vector>
+
 namespace lar_nd_reco
 {
 
@@ -37,6 +44,8 @@ public:
 
     bool IsInTPC(const pandora::CartesianVector &pos) const;
 
+    static constexpr double m_epsilon{1.0e-3}; ///< tolerance added to the TPC limits when checking if a position is inside
+
     double m_x_min; ///< minimum x value of the TPC cubioid
     double m_x_max; ///< maximum x value of the TPC cubioid
     double m_y_min; ///< minimum y value of the TPC cubioid
@@ -70,13 +79,12 @@ inline LArNDTPCSimple::LArNDTPCSimple(const double x_min, const double x_max, co
 
 inline bool LArNDTPCSimple::IsInTPC(const pandora::CartesianVector &pos) const
 {
-    const double epsilon{1.0e-3};
-    const double m_x_min_eps{m_x_min - epsilon};
-    const double m_x_max_eps{m_x_max + epsilon};
-    const double m_y_min_eps{m_y_min - epsilon};
-    const double m_y_max_eps{m_y_max + epsilon};
-    const double m_z_min_eps{m_z_min - epsilon};
-    const double m_z_max_eps{m_z_max + epsilon};
+    const double m_x_min_eps{m_x_min - m_epsilon};
+    const double m_x_max_eps{m_x_max + m_epsilon};
+    const double m_y_min_eps{m_y_min - m_epsilon};
+    const double m_y_max_eps{m_y_max + m_epsilon};
+    const double m_z_min_eps{m_z_min - m_epsilon};
+    const double m_z_max_eps{m_z_max + m_epsilon};
     const double x{pos.GetX()};
     const double y{pos.GetY()};
     const double z{pos.GetZ()};
@@ -90,6 +98,8 @@ inline bool LArNDTPCSimple::IsInTPC(const pandora::CartesianVector &pos) const
     return true;
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 class LArNDGeomSimple
 {
 public:
@@ -141,14 +151,51 @@ public:
      */
     void GetSurroundingBox(double &min_x, double &max_x, double &min_y, double &max_y, double &min_z, double &max_z) const;
 
+    /**
+     *  @brief  Build the spatial index used by GetTPCNumber and GetModuleNumber: a uniform grid of cells over the TPCs, each
+     *          listing the TPCs that can contain a position in that cell. Call once all TPCs have been added
+     */
+    void BuildIndex();
+
     std::map<unsigned int, LArNDTPCSimple> m_TPCs; ///< map of the TPCs keyed on their unique id
 
 private:
+    /**
+     *  @brief  Find the first TPC (in order of increasing id) that contains a 3D position
+     *
+     *  @param  position 3d position to query
+     *
+     *  @return address of the TPC, or nullptr if no TPC contains the position
+     */
+    const LArNDTPCSimple *FindTPC(const pandora::CartesianVector &position) const;
+
+    /**
+     *  @brief  Get the index cell number along one axis
+     *
+     *  @param  value the coordinate value
+     *  @param  axis the axis number (0, 1 or 2 for x, y or z)
+     *
+     *  @return the cell number, clamped to the index range
+     */
+    long GetCellNumber(const double value, const unsigned int axis) const;
+
+    static constexpr long m_maxCellsPerAxis{256}; ///< the maximum number of index cells along each axis
+
+    std::vector<LArNDTPCSimple> m_cellTPCs; ///< copies of the candidate TPCs for all cells, in order of increasing id for each cell
+    std::vector<size_t> m_cellOffsets;      ///< the start of the candidate TPCs of each cell in m_cellTPCs
+    double m_indexMin[3];                   ///< the lower limits of the index, including the TPC tolerance
+    double m_indexMax[3];                   ///< the upper limits of the index, including the TPC tolerance
+    double m_cellWidth[3];                  ///< the index cell widths
+    long m_nCells[3];                       ///< the number of index cells along each axis
 };
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-LArNDGeomSimple::LArNDGeomSimple()
+inline LArNDGeomSimple::LArNDGeomSimple() :
+    m_indexMin{0., 0., 0.},
+    m_indexMax{0., 0., 0.},
+    m_cellWidth{0., 0., 0.},
+    m_nCells{0, 0, 0}
 {
 }
 
@@ -156,24 +203,16 @@ LArNDGeomSimple::LArNDGeomSimple()
 
 inline int LArNDGeomSimple::GetTPCNumber(const pandora::CartesianVector &position) const
 {
-    for (auto const &tpc : m_TPCs)
-    {
-        if (tpc.second.IsInTPC(position))
-            return tpc.first;
-    }
-    return -1;
+    const LArNDTPCSimple *const pTPC(this->FindTPC(position));
+    return pTPC ? pTPC->m_TPC_ID : -1;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 inline int LArNDGeomSimple::GetModuleNumber(const pandora::CartesianVector &position) const
 {
-    for (auto const &tpc : m_TPCs)
-    {
-        if (tpc.second.IsInTPC(position))
-            return tpc.first / 2;
-    }
-    return -1;
+    const LArNDTPCSimple *const pTPC(this->FindTPC(position));
+    return pTPC ? pTPC->m_TPC_ID / 2 : -1;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -185,6 +224,75 @@ inline void LArNDGeomSimple::AddTPC(
         std::cout << "LArNDGeomSimple: trying to add another TPC with tpc id " << tpcID << "! Doing nothing. " << std::endl;
     else
         m_TPCs[tpcID] = LArNDTPCSimple(min_x, max_x, min_y, max_y, min_z, max_z, tpcID);
+
+    // The index needs to be rebuilt
+    m_cellTPCs.clear();
+    m_cellOffsets.clear();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArNDGeomSimple::BuildIndex()
+{
+    m_cellTPCs.clear();
+    m_cellOffsets.clear();
+
+    if (m_TPCs.empty())
+        return;
+
+    // Cover the TPCs, including their tolerance, with cells that are half the size of the smallest TPC along each axis
+    double min[3], max[3];
+    this->GetSurroundingBox(min[0], max[0], min[1], max[1], min[2], max[2]);
+
+    for (unsigned int axis = 0; axis < 3; ++axis)
+    {
+        double smallestWidth(std::numeric_limits<double>::max());
+        for (auto const &tpc : m_TPCs)
+        {
+            const LArNDTPCSimple &box(tpc.second);
+            const double width(axis == 0 ? box.m_x_max - box.m_x_min : axis == 1 ? box.m_y_max - box.m_y_min : box.m_z_max - box.m_z_min);
+            smallestWidth = std::min(smallestWidth, width);
+        }
+
+        m_indexMin[axis] = min[axis] - LArNDTPCSimple::m_epsilon;
+        m_indexMax[axis] = max[axis] + LArNDTPCSimple::m_epsilon;
+        const double range(m_indexMax[axis] - m_indexMin[axis]);
+        const long nCells(smallestWidth > 0. ? static_cast<long>(std::ceil(2. * range / smallestWidth)) : 1);
+        m_nCells[axis] = std::max(1L, std::min(nCells, m_maxCellsPerAxis));
+        m_cellWidth[axis] = range / m_nCells[axis];
+    }
+
+    // Each TPC is a candidate for all cells that overlap its limits plus tolerance. The cell numbers are found in the same
+    // way as for the position lookup, so every position inside a TPC falls in one of its cells
+    const size_t nCells(m_nCells[0] * m_nCells[1] * m_nCells[2]);
+    std::vector<std::vector<const LArNDTPCSimple *>> cellTPCLists(nCells);
+
+    for (auto const &tpc : m_TPCs)
+    {
+        const LArNDTPCSimple &box(tpc.second);
+        const double boxMin[3] = {box.m_x_min - LArNDTPCSimple::m_epsilon, box.m_y_min - LArNDTPCSimple::m_epsilon,
+            box.m_z_min - LArNDTPCSimple::m_epsilon};
+        const double boxMax[3] = {box.m_x_max + LArNDTPCSimple::m_epsilon, box.m_y_max + LArNDTPCSimple::m_epsilon,
+            box.m_z_max + LArNDTPCSimple::m_epsilon};
+
+        for (long ix = this->GetCellNumber(boxMin[0], 0); ix <= this->GetCellNumber(boxMax[0], 0); ++ix)
+        {
+            for (long iy = this->GetCellNumber(boxMin[1], 1); iy <= this->GetCellNumber(boxMax[1], 1); ++iy)
+            {
+                for (long iz = this->GetCellNumber(boxMin[2], 2); iz <= this->GetCellNumber(boxMax[2], 2); ++iz)
+                    cellTPCLists[(ix * m_nCells[1] + iy) * m_nCells[2] + iz].emplace_back(&box);
+            }
+        }
+    }
+
+    m_cellOffsets.reserve(nCells + 1);
+    for (const auto &cellTPCList : cellTPCLists)
+    {
+        m_cellOffsets.emplace_back(m_cellTPCs.size());
+        for (const LArNDTPCSimple *const pTPC : cellTPCList)
+            m_cellTPCs.emplace_back(*pTPC);
+    }
+    m_cellOffsets.emplace_back(m_cellTPCs.size());
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -209,6 +317,47 @@ inline void LArNDGeomSimple::GetSurroundingBox(double &min_x, double &max_x, dou
     }
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline const LArNDTPCSimple *LArNDGeomSimple::FindTPC(const pandora::CartesianVector &position) const
+{
+    const double x{position.GetX()};
+    const double y{position.GetY()};
+    const double z{position.GetZ()};
+
+    // Without an index, or for NaN positions, check every TPC
+    if (m_cellOffsets.empty() || std::isnan(x) || std::isnan(y) || std::isnan(z))
+    {
+        for (auto const &tpc : m_TPCs)
+        {
+            if (tpc.second.IsInTPC(position))
+                return &tpc.second;
+        }
+        return nullptr;
+    }
+
+    // No TPC can contain a position outside the index. Positions on its limits are left to the TPC checks, so that the tolerance
+    // edge is decided by IsInTPC alone
+    if (x < m_indexMin[0] || x > m_indexMax[0] || y < m_indexMin[1] || y > m_indexMax[1] || z < m_indexMin[2] || z > m_indexMax[2])
+        return nullptr;
+
+    const size_t cell((this->GetCellNumber(x, 0) * m_nCells[1] + this->GetCellNumber(y, 1)) * m_nCells[2] + this->GetCellNumber(z, 2));
+    for (size_t i = m_cellOffsets[cell]; i < m_cellOffsets[cell + 1]; ++i)
+    {
+        if (m_cellTPCs[i].IsInTPC(position))
+            return &m_cellTPCs[i];
+    }
+    return nullptr;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline long LArNDGeomSimple::GetCellNumber(const double value, const unsigned int axis) const
+{
+    const long cell(static_cast<long>(std::floor((value - m_indexMin[axis]) / m_cellWidth[axis])));
+    return std::max(0L, std::min(cell, m_nCells[axis] - 1));
+}
+
 } // namespace lar_nd_reco
 
 #endif
@@ -0,0 +1,342 @@
+/**
+ *  @file   include/LArObjectPool.h
+ *
+ *  @brief  Header file for the pooled allocation of the calo hits and mc particles.
+ *
+ *  $Log: $
+ */
+#ifndef LAR_OBJECT_POOL_H
+#define LAR_OBJECT_POOL_H 1
+
+#include "larpandoracontent/LArObjects/LArCaloHit.h"
+#include "larpandoracontent/LArObjects/LArMCParticle.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace lar_content
+{
+
+/**
+ *  @brief  A process-wide pool of memory slots for objects of one type. Memory is taken from the heap in large blocks as the pool
+ *          grows to its high-water mark, and released slots are kept on a free list for reuse, so that in steady state the objects
+ *          of each event reuse the slots of the previous event. The blocks are never returned to the heap
+ */
+template <typename T>
+class LArObjectPool
+{
+public:
+    /**
+     *  @brief  Get the pool for this object type
+     *
+     *  @return the pool
+     */
+    static LArObjectPool &Get();
+
+    /**
+     *  @brief  Allocate the memory for an object
+     *
+     *  @param  size the size of the object, which is served by the heap if it is not the size of the pooled type
+     *
+     *  @return the address of the memory
+     */
+    void *Allocate(const std::size_t size);
+
+    /**
+     *  @brief  Release the memory of an object
+     *
+     *  @param  pMemory the address of the memory
+     *  @param  size the size of the object, as given when allocated
+     */
+    void Release(void *const pMemory, const std::size_t size);
+
+    /**
+     *  @brief  Get the number of slots taken from the heap so far, which is the high-water mark of the pool
+     *
+     *  @return the number of slots
+     */
+    std::size_t GetNSlots() const;
+
+private:
+    /**
+     *  @brief  A slot of the pool, which holds a pointer to the next free slot while on the free list
+     */
+    union Slot
+    {
+        Slot *m_pNextFree;                             ///< The next free slot
+        alignas(T) unsigned char m_storage[sizeof(T)]; ///< The storage for the object
+    };
+
+    /**
+     *  @brief  Default constructor
+     */
+    LArObjectPool();
+
+    /**
+     *  @brief  Take a new block of slots from the heap and add them to the free list
+     */
+    void Grow();
+
+    static constexpr std::size_t m_minSlotsPerBlock{1 << 12}; ///< The number of slots in the first block
+
+    std::mutex m_mutex;           ///< The mutex guarding the free list, as worker instances may run on several threads
+    Slot *m_pFreeList;            ///< The first free slot
+    std::vector<Slot *> m_blocks; ///< The blocks of slots taken from the heap
+    std::size_t m_nSlots;         ///< The total number of slots in the blocks
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  A LArCaloHit whose memory comes from a pool
+ */
+class LArPooledCaloHit : public LArCaloHit
+{
+public:
+    /**
+     *  @brief  Constructor
+     *
+     *  @param  parameters the lar calo hit parameters
+     */
+    LArPooledCaloHit(const LArCaloHitParameters &parameters);
+
+    /**
+     *  @brief  Allocate the memory for a calo hit from the pool
+     *
+     *  @param  size the size of the calo hit
+     *
+     *  @return the address of the memory
+     */
+    static void *operator new(const std::size_t size);
+
+    /**
+     *  @brief  Release the memory of a calo hit to the pool. Pandora deletes the calo hits through their virtual destructor,
+     *          which calls this operator
+     *
+     *  @param  pMemory the address of the memory
+     *  @param  size the size of the calo hit
+     */
+    static void operator delete(void *const pMemory, const std::size_t size);
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  A factory for LArCaloHits whose memory comes from a pool
+ */
+class LArPooledCaloHitFactory : public LArCaloHitFactory
+{
+public:
+    /**
+     *  @brief  Create an object with the given parameters
+     *
+     *  @param  parameters the parameters to pass in constructor
+     *  @param  pObject to receive the address of the object created
+     */
+    pandora::StatusCode Create(const Parameters &parameters, const Object *&pObject) const;
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  A LArMCParticle whose memory comes from a pool
+ */
+class LArPooledMCParticle : public LArMCParticle
+{
+public:
+    /**
+     *  @brief  Constructor
+     *
+     *  @param  parameters the lar mc particle parameters
+     */
+    LArPooledMCParticle(const LArMCParticleParameters &parameters);
+
+    /**
+     *  @brief  Allocate the memory for an mc particle from the pool
+     *
+     *  @param  size the size of the mc particle
+     *
+     *  @return the address of the memory
+     */
+    static void *operator new(const std::size_t size);
+
+    /**
+     *  @brief  Release the memory of an mc particle to the pool. Pandora deletes the mc particles through their virtual destructor,
+     *          which calls this operator
+     *
+     *  @param  pMemory the address of the memory
+     *  @param  size the size of the mc particle
+     */
+    static void operator delete(void *const pMemory, const std::size_t size);
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  A factory for LArMCParticles whose memory comes from a pool
+ */
+class LArPooledMCParticleFactory : public LArMCParticleFactory
+{
+public:
+    /**
+     *  @brief  Create an object with the given parameters
+     *
+     *  @param  parameters the parameters to pass in constructor
+     *  @param  pObject to receive the address of the object created
+     */
+    pandora::StatusCode Create(const Parameters &parameters, const Object *&pObject) const;
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+inline LArObjectPool<T> &LArObjectPool<T>::Get()
+{
+    // ATTN Never destroyed, as pandora may still delete its objects during the destruction of the static objects
+    static LArObjectPool *const pObjectPool(new LArObjectPool);
+    return *pObjectPool;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+inline void *LArObjectPool<T>::Allocate(const std::size_t size)
+{
+    if (size != sizeof(T))
+        return ::operator new(size);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_pFreeList)
+        this->Grow();
+
+    Slot *const pSlot(m_pFreeList);
+    m_pFreeList = pSlot->m_pNextFree;
+
+    return pSlot;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+inline void LArObjectPool<T>::Release(void *const pMemory, const std::size_t size)
+{
+    if (!pMemory)
+        return;
+
+    if (size != sizeof(T))
+    {
+        ::operator delete(pMemory);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Slot *const pSlot(static_cast<Slot *>(pMemory));
+    pSlot->m_pNextFree = m_pFreeList;
+    m_pFreeList = pSlot;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+inline std::size_t LArObjectPool<T>::GetNSlots() const
+{
+    return m_nSlots;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+inline LArObjectPool<T>::LArObjectPool() : m_pFreeList(nullptr), m_nSlots(0)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+inline void LArObjectPool<T>::Grow()
+{
+    // Double the size of the pool each time, so that it reaches its high-water mark in a few steps
+    const std::size_t nNewSlots(std::max(m_minSlotsPerBlock, m_nSlots));
+    Slot *const pBlock(new Slot[nNewSlots]);
+    m_blocks.push_back(pBlock);
+    m_nSlots += nNewSlots;
+
+    for (std::size_t iSlot = 0; iSlot < nNewSlots; ++iSlot)
+    {
+        pBlock[iSlot].m_pNextFree = m_pFreeList;
+        m_pFreeList = &pBlock[iSlot];
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArPooledCaloHit::LArPooledCaloHit(const LArCaloHitParameters &parameters) : LArCaloHit(parameters)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void *LArPooledCaloHit::operator new(const std::size_t size)
+{
+    return LArObjectPool<LArPooledCaloHit>::Get().Allocate(size);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArPooledCaloHit::operator delete(void *const pMemory, const std::size_t size)
+{
+    LArObjectPool<LArPooledCaloHit>::Get().Release(pMemory, size);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline pandora::StatusCode LArPooledCaloHitFactory::Create(const Parameters &parameters, const Object *&pObject) const
+{
+    const LArCaloHitParameters &larCaloHitParameters(dynamic_cast<const LArCaloHitParameters &>(parameters));
+    pObject = new LArPooledCaloHit(larCaloHitParameters);
+
+    return pandora::STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArPooledMCParticle::LArPooledMCParticle(const LArMCParticleParameters &parameters) : LArMCParticle(parameters)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void *LArPooledMCParticle::operator new(const std::size_t size)
+{
+    return LArObjectPool<LArPooledMCParticle>::Get().Allocate(size);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArPooledMCParticle::operator delete(void *const pMemory, const std::size_t size)
+{
+    LArObjectPool<LArPooledMCParticle>::Get().Release(pMemory, size);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline pandora::StatusCode LArPooledMCParticleFactory::Create(const Parameters &parameters, const Object *&pObject) const
+{
+    const LArMCParticleParameters &larMCParticleParameters(dynamic_cast<const LArMCParticleParameters &>(parameters));
+    pObject = new LArPooledMCParticle(larMCParticleParameters);
+
+    return pandora::STATUS_CODE_SUCCESS;
+}
+
+} // namespace lar_content
+
+#endif // #ifndef LAR_OBJECT_POOL_H
@@ -0,0 +1,118 @@
+/**
+ *  @file   include/LArProcessShard.h
+ *
+ *  @brief  Header file for the share of the input events handled by this process.
+ *
+ *  $Log: $
+ */
+#ifndef LAR_PROCESS_SHARD_H
+#define LAR_PROCESS_SHARD_H 1
+
+#include <string>
+
+namespace lar_content
+{
+
+/**
+ *  @brief  The share of the input events handled by this process, when the application forks several processes after
+ *          initialisation. Each process has its own copy, set by the application and read by the output algorithms
+ */
+class LArProcessShard
+{
+public:
+    enum Role
+    {
+        SINGLE_PROCESS = 0, ///< Not sharing the events
+        PARENT = 1,         ///< The parent process, which waits for the children and processes no events
+        CHILD = 2           ///< A child process, which processes its own share of the events
+    };
+
+    /**
+     *  @brief  Get the process shard description of this process
+     *
+     *  @return the process shard description
+     */
+    static LArProcessShard &Get();
+
+    /**
+     *  @brief  Get the input event entry of the event being processed, relative to the first entry of the whole job. This is the
+     *          entry set by the application, which accounts for any events it skipped, or else the entry found from the count
+     *
+     *  @param  count the number of events processed so far by this process
+     *
+     *  @return the input event entry
+     */
+    int GetEventEntry(const int count) const;
+
+    /**
+     *  @brief  Get the name of the output file for this process, with "_shard<index>" added before the extension for a child
+     *
+     *  @param  fileName the output file name of the whole job
+     *
+     *  @return the output file name
+     */
+    std::string GetFileName(const std::string &fileName) const;
+
+    Role m_role;       ///< The role of this process
+    int m_shardIndex;  ///< The index of the child process, or -1
+    int m_eventOffset; ///< The first input event entry of this process, relative to the first entry of the whole job
+    int m_eventStride; ///< The step between the input event entries of this process
+    int m_nEvents;     ///< The number of input events in the share of this process
+    int m_nProcesses;  ///< The number of child processes sharing the events, or 1
+    int m_eventEntry;  ///< The input event entry of the event being processed, relative to the first entry of the whole job, or -1
+
+private:
+    /**
+     *  @brief  Default constructor
+     */
+    LArProcessShard();
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArProcessShard &LArProcessShard::Get()
+{
+    static LArProcessShard processShard;
+    return processShard;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArProcessShard::LArProcessShard() :
+    m_role(SINGLE_PROCESS),
+    m_shardIndex(-1),
+    m_eventOffset(0),
+    m_eventStride(1),
+    m_nEvents(0),
+    m_nProcesses(1),
+    m_eventEntry(-1)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline int LArProcessShard::GetEventEntry(const int count) const
+{
+    return (m_eventEntry >= 0) ? m_eventEntry : m_eventOffset + count * m_eventStride;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline std::string LArProcessShard::GetFileName(const std::string &fileName) const
+{
+    if (CHILD != m_role)
+        return fileName;
+
+    const std::string suffix("_shard" + std::to_string(m_shardIndex));
+    const std::size_t dirPos(fileName.find_last_of('/'));
+    const std::size_t extPos(fileName.find_last_of('.'));
+
+    if ((std::string::npos == extPos) || ((std::string::npos != dirPos) && (extPos < dirPos)))
+        return fileName + suffix;
+
+    return fileName.substr(0, extPos) + suffix + fileName.substr(extPos);
+}
+
+} // namespace lar_content
+
+#endif // #ifndef LAR_PROCESS_SHARD_H
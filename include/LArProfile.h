@@ -0,0 +1,337 @@
+/**
+ *  @file   include/LArProfile.h
+ *
+ *  @brief  Header file for the timing profile of the algorithms and worker instances.
+ *
+ *  $Log: $
+ */
+#ifndef LAR_PROFILE_H
+#define LAR_PROFILE_H 1
+
+#include "LArProcessShard.h"
+#include "LArSubEvent.h"
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace pandora
+{
+class Pandora;
+}
+
+namespace lar_content
+{
+
+/**
+ *  @brief  The wall and cpu time of each profiled algorithm invocation and worker instance event, tagged with the pandora instance
+ *          name, slice index and number of hits. Enabled by the application, which writes the entries of each event to a csv file and
+ *          prints a summary at the end of the job. When disabled, nothing is recorded
+ */
+class LArProfile
+{
+public:
+    /**
+     *  @brief  Get the profile of this process
+     *
+     *  @return the profile
+     */
+    static LArProfile &Get();
+
+    /**
+     *  @brief  Get the current wall time
+     *
+     *  @return the wall time, in seconds
+     */
+    static double GetWallTime();
+
+    /**
+     *  @brief  Get the cpu time used so far by the calling thread
+     *
+     *  @return the cpu time, in seconds
+     */
+    static double GetCPUTime();
+
+    /**
+     *  @brief  Enable the profile
+     *
+     *  @param  fileName the name of the csv file for the entries of each event, with "_shard<index>" added for a child process
+     */
+    void Enable(const std::string &fileName);
+
+    /**
+     *  @brief  Whether the profile is enabled
+     *
+     *  @return boolean
+     */
+    bool IsEnabled() const;
+
+    /**
+     *  @brief  Set the name of a pandora instance
+     *
+     *  @param  pPandora the address of the pandora instance
+     *  @param  name the name
+     */
+    void SetInstanceName(const pandora::Pandora *const pPandora, const std::string &name);
+
+    /**
+     *  @brief  Set the slice and number of hits given to a pandora instance for its next event. Call before the instance processes
+     *          its event, and not while any instance is processing an event on another thread
+     *
+     *  @param  pPandora the address of the pandora instance
+     *  @param  sliceIndex the slice index, or -1 if the instance processes more than a slice
+     *  @param  nHits the number of hits
+     */
+    void SetInstanceEvent(const pandora::Pandora *const pPandora, const int sliceIndex, const unsigned int nHits);
+
+    /**
+     *  @brief  Add an entry, which may be called concurrently for different pandora instances
+     *
+     *  @param  pPandora the address of the pandora instance
+     *  @param  name the name of the algorithm or step
+     *  @param  nHits the number of hits, or a negative value for the number of hits given to the instance for its event
+     *  @param  wallTime the wall time, in seconds
+     *  @param  cpuTime the cpu time, in seconds
+     */
+    void AddEntry(const pandora::Pandora *const pPandora, const std::string &name, const int nHits, const double wallTime,
+        const double cpuTime);
+
+    /**
+     *  @brief  Write the entries of the event to the csv file, add them to the summary and clear them. The sub-events of a spill
+     *          are written with the event entry of their spill
+     */
+    void EndEvent();
+
+    /**
+     *  @brief  Print the summary of the entries of all events, grouping the numbered instances of a kind of worker
+     */
+    void PrintSummary() const;
+
+private:
+    /**
+     *  @brief  The profile information of a pandora instance
+     */
+    class Instance
+    {
+    public:
+        std::string m_name;   ///< The name of the instance
+        int m_sliceIndex;     ///< The slice given to the instance for its event, or -1
+        unsigned int m_nHits; ///< The number of hits given to the instance for its event
+    };
+
+    /**
+     *  @brief  An entry of the profile
+     */
+    class Entry
+    {
+    public:
+        std::string m_instanceName; ///< The name of the pandora instance
+        int m_sliceIndex;           ///< The slice index, or -1
+        unsigned int m_nHits;       ///< The number of hits
+        std::string m_name;         ///< The name of the algorithm or step
+        double m_wallTime;          ///< The wall time, in seconds
+        double m_cpuTime;           ///< The cpu time, in seconds
+    };
+
+    /**
+     *  @brief  The summed entries of an algorithm or step of a kind of pandora instance
+     */
+    class Summary
+    {
+    public:
+        unsigned int m_nCalls; ///< The number of entries
+        double m_wallTime;     ///< The total wall time, in seconds
+        double m_cpuTime;      ///< The total cpu time, in seconds
+    };
+
+    typedef std::unordered_map<const pandora::Pandora *, Instance> InstanceMap;
+    typedef std::map<std::pair<std::string, std::string>, Summary> SummaryMap;
+
+    /**
+     *  @brief  Default constructor
+     */
+    LArProfile();
+
+    bool m_isEnabled;             ///< Whether the profile is enabled
+    std::string m_fileName;       ///< The name of the csv file of the whole job
+    std::ofstream m_file;         ///< The csv file
+    int m_eventCount;             ///< The number of input events ended so far
+    InstanceMap m_instanceMap;    ///< The profile information of each named pandora instance
+    std::mutex m_mutex;           ///< The mutex guarding the entries
+    std::vector<Entry> m_entries; ///< The entries of the current event
+    SummaryMap m_summaryMap;      ///< The summed entries, keyed on the kind of instance and the algorithm or step
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArProfile &LArProfile::Get()
+{
+    static LArProfile profile;
+    return profile;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline double LArProfile::GetWallTime()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline double LArProfile::GetCPUTime()
+{
+    timespec cpuTime;
+    if (0 != clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpuTime))
+        return 0.;
+
+    return static_cast<double>(cpuTime.tv_sec) + 1.e-9 * static_cast<double>(cpuTime.tv_nsec);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArProfile::Enable(const std::string &fileName)
+{
+    m_isEnabled = true;
+    m_fileName = fileName;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline bool LArProfile::IsEnabled() const
+{
+    return m_isEnabled;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArProfile::SetInstanceName(const pandora::Pandora *const pPandora, const std::string &name)
+{
+    Instance &instance(m_instanceMap[pPandora]);
+    instance.m_name = name;
+    instance.m_sliceIndex = -1;
+    instance.m_nHits = 0;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArProfile::SetInstanceEvent(const pandora::Pandora *const pPandora, const int sliceIndex, const unsigned int nHits)
+{
+    if (!m_isEnabled)
+        return;
+
+    InstanceMap::iterator iter(m_instanceMap.find(pPandora));
+    if (m_instanceMap.end() == iter)
+        return;
+
+    iter->second.m_sliceIndex = sliceIndex;
+    iter->second.m_nHits = nHits;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArProfile::AddEntry(
+    const pandora::Pandora *const pPandora, const std::string &name, const int nHits, const double wallTime, const double cpuTime)
+{
+    if (!m_isEnabled)
+        return;
+
+    Entry entry{"Unknown", -1, 0, name, wallTime, cpuTime};
+    const InstanceMap::const_iterator iter(m_instanceMap.find(pPandora));
+
+    if (m_instanceMap.end() != iter)
+    {
+        entry.m_instanceName = iter->second.m_name;
+        entry.m_sliceIndex = iter->second.m_sliceIndex;
+        entry.m_nHits = iter->second.m_nHits;
+    }
+
+    if (nHits >= 0)
+        entry.m_nHits = nHits;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.push_back(std::move(entry));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArProfile::EndEvent()
+{
+    if (!m_isEnabled)
+        return;
+
+    if (LArSubEvent::Get().m_isNewSpill)
+        ++m_eventCount;
+
+    if (!m_file.is_open())
+    {
+        m_file.open(LArProcessShard::Get().GetFileName(m_fileName), std::ios::trunc);
+        m_file << "event,subEvent,instance,slice,nHits,algorithm,wallTimeMs,cpuTimeMs" << std::endl;
+    }
+
+    const int eventEntry(LArProcessShard::Get().GetEventEntry(m_eventCount - 1));
+    const int subEventIndex(LArSubEvent::Get().m_subEventIndex);
+
+    for (const Entry &entry : m_entries)
+    {
+        m_file << eventEntry << "," << subEventIndex << "," << entry.m_instanceName << "," << entry.m_sliceIndex << ","
+               << entry.m_nHits << "," << entry.m_name << "," << 1000. * entry.m_wallTime << "," << 1000. * entry.m_cpuTime << "\n";
+
+        // Group the numbered instances of each kind of worker
+        const std::string kind(entry.m_instanceName.substr(0, entry.m_instanceName.find_last_not_of("0123456789") + 1));
+        Summary &summary(m_summaryMap.emplace(std::make_pair(kind, entry.m_name), Summary{0, 0., 0.}).first->second);
+        ++summary.m_nCalls;
+        summary.m_wallTime += entry.m_wallTime;
+        summary.m_cpuTime += entry.m_cpuTime;
+    }
+
+    m_file.flush();
+    m_entries.clear();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArProfile::PrintSummary() const
+{
+    if (!m_isEnabled || (0 == m_eventCount))
+        return;
+
+    std::vector<SummaryMap::const_iterator> rows;
+    for (SummaryMap::const_iterator iter = m_summaryMap.begin(); iter != m_summaryMap.end(); ++iter)
+        rows.push_back(iter);
+
+    std::sort(rows.begin(), rows.end(), [](const SummaryMap::const_iterator &lhs, const SummaryMap::const_iterator &rhs)
+        { return lhs->second.m_wallTime > rhs->second.m_wallTime; });
+
+    std::cout << "Timing profile of " << m_eventCount << " input event(s), most expensive first, including the times of nested entries"
+              << std::endl
+              << std::left << std::setw(24) << "Instance" << std::setw(48) << "Algorithm" << std::right << std::setw(10) << "Calls"
+              << std::setw(14) << "Wall (s)" << std::setw(14) << "CPU (s)" << std::setw(16) << "Wall/call (ms)" << std::endl;
+
+    for (const SummaryMap::const_iterator &iter : rows)
+    {
+        const Summary &summary(iter->second);
+        std::cout << std::left << std::setw(24) << iter->first.first << std::setw(48) << iter->first.second << std::right << std::setw(10)
+                  << summary.m_nCalls << std::fixed << std::setprecision(3) << std::setw(14) << summary.m_wallTime << std::setw(14)
+                  << summary.m_cpuTime << std::setw(16) << 1000. * summary.m_wallTime / summary.m_nCalls << std::defaultfloat << std::endl;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArProfile::LArProfile() : m_isEnabled(false), m_eventCount(0)
+{
+}
+
+} // namespace lar_content
+
+#endif // #ifndef LAR_PROFILE_H
@@ -10,6 +10,7 @@
 
 #include "Pandora/PandoraInputTypes.h"
 #include <array>
+#include <vector>
 
 namespace lar_nd_reco
 {
@@ -89,6 +90,99 @@ inline pandora::CartesianVector LArRay::GetPoint(const double length) const
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+class LArRayBatch
+{
+public:
+    /**
+     *  @brief  Reserve space for the given number of rays
+     *
+     *  @param  nRays The number of rays
+     */
+    void Reserve(const std::size_t nRays);
+
+    /**
+     *  @brief  Append a ray to the batch, copying its origin, reciprocal direction and signs
+     *
+     *  @param  ray The ray
+     */
+    void AddRay(const LArRay &ray);
+
+    /**
+     *  @brief  Remove all rays from the batch, keeping the allocated capacity
+     */
+    void Clear();
+
+    /**
+     *  @brief  Get the number of rays in the batch
+     *
+     *  @return The number of rays
+     */
+    std::size_t GetSize() const;
+
+    std::vector<double> m_originX; ///< Starting point x components, stored in the precision used by the slab test
+    std::vector<double> m_originY; ///< Starting point y components
+    std::vector<double> m_originZ; ///< Starting point z components
+    std::vector<double> m_invDirX; ///< Reciprocal direction x components
+    std::vector<double> m_invDirY; ///< Reciprocal direction y components
+    std::vector<double> m_invDirZ; ///< Reciprocal direction z components
+    std::vector<int> m_signX;      ///< Sign of the reciprocal direction x components
+    std::vector<int> m_signY;      ///< Sign of the reciprocal direction y components
+    std::vector<int> m_signZ;      ///< Sign of the reciprocal direction z components
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArRayBatch::Reserve(const std::size_t nRays)
+{
+    m_originX.reserve(nRays);
+    m_originY.reserve(nRays);
+    m_originZ.reserve(nRays);
+    m_invDirX.reserve(nRays);
+    m_invDirY.reserve(nRays);
+    m_invDirZ.reserve(nRays);
+    m_signX.reserve(nRays);
+    m_signY.reserve(nRays);
+    m_signZ.reserve(nRays);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArRayBatch::AddRay(const LArRay &ray)
+{
+    m_originX.emplace_back(ray.m_origin.GetX());
+    m_originY.emplace_back(ray.m_origin.GetY());
+    m_originZ.emplace_back(ray.m_origin.GetZ());
+    m_invDirX.emplace_back(ray.m_invDir.GetX());
+    m_invDirY.emplace_back(ray.m_invDir.GetY());
+    m_invDirZ.emplace_back(ray.m_invDir.GetZ());
+    m_signX.emplace_back(ray.m_sign[0]);
+    m_signY.emplace_back(ray.m_sign[1]);
+    m_signZ.emplace_back(ray.m_sign[2]);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArRayBatch::Clear()
+{
+    m_originX.clear();
+    m_originY.clear();
+    m_originZ.clear();
+    m_invDirX.clear();
+    m_invDirY.clear();
+    m_invDirZ.clear();
+    m_signX.clear();
+    m_signY.clear();
+    m_signZ.clear();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline std::size_t LArRayBatch::GetSize() const
+{
+    return m_originX.size();
+}
 
 } // namespace lar_nd_reco
 
@@ -0,0 +1,72 @@
+/**
+ *  @file   include/LArServerJob.h
+ *
+ *  @brief  Header file for the input file currently processed by a persistent server process.
+ *
+ *  $Log: $
+ */
+#ifndef LAR_SERVER_JOB_H
+#define LAR_SERVER_JOB_H 1
+
+#include <string>
+
+namespace lar_content
+{
+
+/**
+ *  @brief  The input and output files of the current job, when the application runs as a persistent server that processes a
+ *          queue of input files with a single initialisation. Set by the application and read by the output algorithms
+ */
+class LArServerJob
+{
+public:
+    /**
+     *  @brief  Get the server job description of this process
+     *
+     *  @return the server job description
+     */
+    static LArServerJob &Get();
+
+    /**
+     *  @brief  Whether the application runs as a server, with one job per input file
+     *
+     *  @return boolean
+     */
+    bool IsServer() const;
+
+    unsigned int m_jobNumber;     ///< The number of the current job, counting from 1, or 0 if not running as a server
+    std::string m_inputFileName;  ///< The input events file of the current job
+    std::string m_outputFileName; ///< The analysis output file of the current job
+    bool m_isFinished;            ///< Whether all events of the current job have been processed, so its output can be written
+
+private:
+    /**
+     *  @brief  Default constructor
+     */
+    LArServerJob();
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArServerJob &LArServerJob::Get()
+{
+    static LArServerJob serverJob;
+    return serverJob;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline bool LArServerJob::IsServer() const
+{
+    return (m_jobNumber > 0);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArServerJob::LArServerJob() : m_jobNumber(0), m_isFinished(false)
+{
+}
+
+} // namespace lar_content
+
+#endif // #ifndef LAR_SERVER_JOB_H
@@ -0,0 +1,227 @@
+/**
+ *  @file   include/LArSliceFile.h
+ *
+ *  @brief  Header file for the side file of the slicing results of each event.
+ *
+ *  $Log: $
+ */
+#ifndef LAR_SLICE_FILE_H
+#define LAR_SLICE_FILE_H 1
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace lar_content
+{
+
+typedef std::vector<std::vector<std::uint32_t>> LArSliceHitIdVector;
+
+/**
+ *  @brief  Binary side file of the slices of each event, as lists of hit ids, so that a later job can run the slice reconstruction
+ *          without repeating the slicing. The file is a sequence of self-contained event records, so the files written by the
+ *          processes of a sharded job can simply be concatenated
+ */
+class LArSliceFile
+{
+public:
+    /**
+     *  @brief  Open a file to write the event records, replacing any existing file
+     *
+     *  @param  fileName the file name
+     *
+     *  @return whether the file could be opened
+     */
+    bool OpenForWriting(const std::string &fileName);
+
+    /**
+     *  @brief  Open a file to read the event records, and index the records by event entry
+     *
+     *  @param  fileName the file name
+     *
+     *  @return whether the file exists and only holds valid records
+     */
+    bool OpenForReading(const std::string &fileName);
+
+    /**
+     *  @brief  Whether the file is open
+     *
+     *  @return boolean
+     */
+    bool IsOpen() const;
+
+    /**
+     *  @brief  Write the record of an event
+     *
+     *  @param  eventEntry the input event entry
+     *  @param  nInputHits the number of input hits of the event, to check that a later job has the same input
+     *  @param  sliceHitIds the hit ids of each slice
+     *
+     *  @return whether the record was written
+     */
+    bool WriteEvent(const int eventEntry, const std::uint32_t nInputHits, const LArSliceHitIdVector &sliceHitIds);
+
+    /**
+     *  @brief  Read the record of an event
+     *
+     *  @param  eventEntry the input event entry
+     *  @param  nInputHits to receive the number of input hits of the event
+     *  @param  sliceHitIds to receive the hit ids of each slice
+     *
+     *  @return whether the file has a record for the event
+     */
+    bool ReadEvent(const int eventEntry, std::uint32_t &nInputHits, LArSliceHitIdVector &sliceHitIds);
+
+private:
+    /**
+     *  @brief  The fixed-size header of an event record
+     */
+    class RecordHeader
+    {
+    public:
+        char m_magic[8];            ///< The identifier at the start of each record
+        std::uint32_t m_version;    ///< The version of the record format
+        std::int32_t m_eventEntry;  ///< The input event entry
+        std::uint32_t m_nInputHits; ///< The number of input hits of the event
+        std::uint32_t m_nSlices;    ///< The number of slices
+        std::uint32_t m_nHitIds;    ///< The total number of hit ids in the slices
+    };
+
+    /**
+     *  @brief  Read a record header at the current position of the input file
+     *
+     *  @param  header to receive the header
+     *
+     *  @return whether a valid header was read
+     */
+    bool ReadHeader(RecordHeader &header);
+
+    static constexpr char m_magic[8] = {'L', 'A', 'R', 'N', 'D', 'S', 'L', 'C'}; ///< The identifier at the start of each record
+    static constexpr std::uint32_t m_version{1};                               ///< The version of the record format
+
+    std::ofstream m_outputFile;                             ///< The output file
+    std::ifstream m_inputFile;                              ///< The input file
+    std::unordered_map<int, std::streamoff> m_entryOffsets; ///< The offset of the record of each input event entry
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline bool LArSliceFile::OpenForWriting(const std::string &fileName)
+{
+    m_outputFile.open(fileName, std::ios::binary | std::ios::trunc);
+    return static_cast<bool>(m_outputFile);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline bool LArSliceFile::OpenForReading(const std::string &fileName)
+{
+    m_inputFile.open(fileName, std::ios::binary);
+    if (!m_inputFile)
+        return false;
+
+    m_inputFile.seekg(0, std::ios::end);
+    const std::streamoff fileSize(m_inputFile.tellg());
+    m_inputFile.seekg(0, std::ios::beg);
+
+    // Index the records, skipping their bodies
+    m_entryOffsets.clear();
+    RecordHeader header;
+    std::streamoff offset(0);
+
+    while (offset < fileSize)
+    {
+        if (!this->ReadHeader(header))
+            return false;
+
+        m_entryOffsets[header.m_eventEntry] = offset;
+        offset += sizeof(header) + sizeof(std::uint32_t) * (static_cast<std::streamoff>(header.m_nSlices) + header.m_nHitIds);
+
+        if (offset > fileSize)
+            return false;
+
+        m_inputFile.seekg(offset);
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline bool LArSliceFile::IsOpen() const
+{
+    return m_outputFile.is_open() || m_inputFile.is_open();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline bool LArSliceFile::WriteEvent(const int eventEntry, const std::uint32_t nInputHits, const LArSliceHitIdVector &sliceHitIds)
+{
+    RecordHeader header;
+    std::copy(m_magic, m_magic + sizeof(m_magic), header.m_magic);
+    header.m_version = m_version;
+    header.m_eventEntry = eventEntry;
+    header.m_nInputHits = nInputHits;
+    header.m_nSlices = sliceHitIds.size();
+    header.m_nHitIds = 0;
+
+    std::vector<std::uint32_t> sliceSizes;
+    for (const std::vector<std::uint32_t> &hitIds : sliceHitIds)
+    {
+        sliceSizes.push_back(hitIds.size());
+        header.m_nHitIds += hitIds.size();
+    }
+
+    m_outputFile.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    m_outputFile.write(reinterpret_cast<const char *>(sliceSizes.data()), sizeof(std::uint32_t) * sliceSizes.size());
+
+    for (const std::vector<std::uint32_t> &hitIds : sliceHitIds)
+        m_outputFile.write(reinterpret_cast<const char *>(hitIds.data()), sizeof(std::uint32_t) * hitIds.size());
+
+    // Keep the records of the completed events if the job stops early
+    return static_cast<bool>(m_outputFile.flush());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline bool LArSliceFile::ReadEvent(const int eventEntry, std::uint32_t &nInputHits, LArSliceHitIdVector &sliceHitIds)
+{
+    const std::unordered_map<int, std::streamoff>::const_iterator iter(m_entryOffsets.find(eventEntry));
+    if (m_entryOffsets.end() == iter)
+        return false;
+
+    RecordHeader header;
+    m_inputFile.seekg(iter->second);
+
+    if (!this->ReadHeader(header))
+        return false;
+
+    std::vector<std::uint32_t> sliceSizes(header.m_nSlices);
+    m_inputFile.read(reinterpret_cast<char *>(sliceSizes.data()), sizeof(std::uint32_t) * sliceSizes.size());
+
+    sliceHitIds.clear();
+    for (const std::uint32_t sliceSize : sliceSizes)
+    {
+        sliceHitIds.emplace_back(sliceSize);
+        m_inputFile.read(reinterpret_cast<char *>(sliceHitIds.back().data()), sizeof(std::uint32_t) * sliceSize);
+    }
+
+    nInputHits = header.m_nInputHits;
+    return static_cast<bool>(m_inputFile);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline bool LArSliceFile::ReadHeader(RecordHeader &header)
+{
+    m_inputFile.read(reinterpret_cast<char *>(&header), sizeof(header));
+
+    return m_inputFile && std::equal(header.m_magic, header.m_magic + sizeof(header.m_magic), m_magic) && (m_version == header.m_version);
+}
+
+} // namespace lar_content
+
+#endif // #ifndef LAR_SLICE_FILE_H
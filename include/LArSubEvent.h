@@ -0,0 +1,91 @@
+/**
+ *  @file   include/LArSubEvent.h
+ *
+ *  @brief  Header file for the time window of the sub-event of a spill being reconstructed.
+ *
+ *  $Log: $
+ */
+#ifndef LAR_SUB_EVENT_H
+#define LAR_SUB_EVENT_H 1
+
+namespace lar_content
+{
+
+/**
+ *  @brief  The sub-event being reconstructed, when the application splits each spill into sub-events of space points separated in
+ *          time. Set by the application and read by the algorithms that count the input events or tag their output
+ */
+class LArSubEvent
+{
+public:
+    /**
+     *  @brief  Get the sub-event being reconstructed
+     *
+     *  @return the sub-event
+     */
+    static LArSubEvent &Get();
+
+    /**
+     *  @brief  Reset to the whole spill being reconstructed as one event
+     */
+    void Clear();
+
+    /**
+     *  @brief  Set the sub-event about to be reconstructed
+     *
+     *  @param  subEventIndex the index of the sub-event in its spill
+     *  @param  startTime the time of the earliest space point of the sub-event
+     *  @param  endTime the time of the latest space point of the sub-event
+     *  @param  isNewSpill whether this is the first sub-event of its spill to be reconstructed
+     */
+    void Set(const int subEventIndex, const float startTime, const float endTime, const bool isNewSpill);
+
+    int m_subEventIndex; ///< The index of the sub-event in its spill, or -1 if the whole spill is reconstructed as one event
+    float m_startTime;   ///< The time of the earliest space point of the sub-event
+    float m_endTime;     ///< The time of the latest space point of the sub-event
+    bool m_isNewSpill;   ///< Whether this is the first event reconstructed for its spill, so the counts of input events advance
+
+private:
+    /**
+     *  @brief  Default constructor
+     */
+    LArSubEvent();
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArSubEvent &LArSubEvent::Get()
+{
+    static LArSubEvent subEvent;
+    return subEvent;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArSubEvent::Clear()
+{
+    m_subEventIndex = -1;
+    m_startTime = 0.f;
+    m_endTime = 0.f;
+    m_isNewSpill = true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArSubEvent::Set(const int subEventIndex, const float startTime, const float endTime, const bool isNewSpill)
+{
+    m_subEventIndex = subEventIndex;
+    m_startTime = startTime;
+    m_endTime = endTime;
+    m_isNewSpill = isNewSpill;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArSubEvent::LArSubEvent() : m_subEventIndex(-1), m_startTime(0.f), m_endTime(0.f), m_isNewSpill(true)
+{
+}
+
+} // namespace lar_content
+
+#endif // #ifndef LAR_SUB_EVENT_H
@@ -9,11 +9,136 @@
 #define PANDORA_LAR_VOXEL_H 1
 
 #include "Pandora/PandoraInputTypes.h"
+#include <array>
 #include <vector>
 
 namespace lar_nd_reco
 {
 
+class LArMCContributions
+{
+public:
+    static const unsigned int MaxContributors = 4; ///< The number of track contributions stored inline
+
+    /**
+     *  @brief  Default constructor, with no contributions
+     */
+    LArMCContributions();
+
+    /**
+     *  @brief  Constructor with a single contribution
+     *
+     *  @param  trackID The Geant4 ID of the contributing track
+     *  @param  energy The energy (GeV) deposited by the track
+     */
+    LArMCContributions(const long trackID, const float energy);
+
+    /**
+     *  @brief  Add a track contribution. Once all inline slots are used, the smallest contribution is dropped
+     *
+     *  @param  trackID The Geant4 ID of the contributing track
+     *  @param  energy The energy (GeV) deposited by the track
+     */
+    void Add(const long trackID, const float energy);
+
+    /**
+     *  @brief  Add all of the contributions from another record
+     *
+     *  @param  other The other contribution record
+     */
+    void Add(const LArMCContributions &other);
+
+    /**
+     *  @brief  Get the ID of the track with the largest stored energy contribution
+     *
+     *  @return The track ID, or -1 if there are no contributions
+     */
+    long GetMainTrackID() const;
+
+    std::array<long, MaxContributors> m_trackIDs;  ///< The Geant4 IDs of the largest contributing tracks
+    std::array<float, MaxContributors> m_energies; ///< The energies (GeV) of the largest contributing tracks
+    unsigned int m_nContributors;                  ///< The number of used inline slots
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArMCContributions::LArMCContributions() : m_trackIDs{}, m_energies{}, m_nContributors(0)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArMCContributions::LArMCContributions(const long trackID, const float energy) :
+    m_trackIDs{}, m_energies{}, m_nContributors(1)
+{
+    m_trackIDs[0] = trackID;
+    m_energies[0] = energy;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArMCContributions::Add(const long trackID, const float energy)
+{
+    for (unsigned int i = 0; i < m_nContributors; ++i)
+    {
+        if (m_trackIDs[i] == trackID)
+        {
+            m_energies[i] += energy;
+            return;
+        }
+    }
+
+    if (m_nContributors < MaxContributors)
+    {
+        m_trackIDs[m_nContributors] = trackID;
+        m_energies[m_nContributors] = energy;
+        ++m_nContributors;
+        return;
+    }
+
+    // All slots are used: keep the largest contributions inline. The energy of a dropped contribution is still part of the voxel
+    // energy, but no calo hit relationship is made for its track
+    unsigned int smallest(0);
+    for (unsigned int i = 1; i < MaxContributors; ++i)
+    {
+        if (m_energies[i] < m_energies[smallest])
+            smallest = i;
+    }
+
+    if (energy > m_energies[smallest])
+    {
+        m_trackIDs[smallest] = trackID;
+        m_energies[smallest] = energy;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArMCContributions::Add(const LArMCContributions &other)
+{
+    for (unsigned int i = 0; i < other.m_nContributors; ++i)
+        this->Add(other.m_trackIDs[i], other.m_energies[i]);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline long LArMCContributions::GetMainTrackID() const
+{
+    if (m_nContributors == 0)
+        return -1;
+
+    unsigned int best(0);
+    for (unsigned int i = 1; i < m_nContributors; ++i)
+    {
+        if (m_energies[i] > m_energies[best])
+            best = i;
+    }
+
+    return m_trackIDs[best];
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 class LArVoxel
 {
 public:
@@ -52,11 +177,21 @@ public:
      */
     void SetTrackID(const int trackid);
 
+    /**
+     *  @brief  Record that this voxel now represents another voxel, along with the input voxels that the other voxel represents
+     *
+     *  @param  voxel the other voxel
+     */
+    void AddInputVoxels(const LArVoxel &voxel);
+
     long m_voxelID;                          ///< The long integer ID of the voxel (can be larger than 2^31)
     float m_energyInVoxel;                   ///< The energy in the voxel (GeV)
     pandora::CartesianVector m_voxelPosVect; ///< Position vector (x,y,z) of the first voxel corner
-    int m_trackID;                           ///< The Geant4 ID of the (first) contributing track to this voxel
-    int m_tpcID;
+    int m_trackID;                           ///< The Geant4 ID of the main contributing track to this voxel
+    int m_tpcID;                             ///< ID of the TPC containing this voxel
+    LArMCContributions m_mcContributions;    ///< The energy contributions of the tracks depositing energy in this voxel
+    pandora::CartesianVector m_runVector;    ///< Vector from the first to the last voxel of the collinear run it represents, if any
+    std::vector<long> m_inputVoxelIDs;       ///< IDs of the input voxels it represents after compression or coarsening, empty if none
 };
 
 typedef std::vector<LArVoxel> LArVoxelList;
@@ -64,7 +199,13 @@ typedef std::vector<LArVoxel> LArVoxelList;
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 inline LArVoxel::LArVoxel(const long voxelID, const float energyInVoxel, const pandora::CartesianVector &voxelPosVect, const int trackID) :
-    m_voxelID(voxelID), m_energyInVoxel(energyInVoxel), m_voxelPosVect(voxelPosVect), m_trackID(trackID), m_tpcID(0)
+    m_voxelID(voxelID),
+    m_energyInVoxel(energyInVoxel),
+    m_voxelPosVect(voxelPosVect),
+    m_trackID(trackID),
+    m_tpcID(0),
+    m_mcContributions(trackID, energyInVoxel),
+    m_runVector(0.f, 0.f, 0.f)
 {
 }
 
@@ -72,7 +213,13 @@ inline LArVoxel::LArVoxel(const long voxelID, const float energyInVoxel, const p
 
 inline LArVoxel::LArVoxel(const long voxelID, const float energyInVoxel, const pandora::CartesianVector &voxelPosVect, const int trackID,
     const unsigned int tpcID) :
-    m_voxelID(voxelID), m_energyInVoxel(energyInVoxel), m_voxelPosVect(voxelPosVect), m_trackID(trackID), m_tpcID(tpcID)
+    m_voxelID(voxelID),
+    m_energyInVoxel(energyInVoxel),
+    m_voxelPosVect(voxelPosVect),
+    m_trackID(trackID),
+    m_tpcID(tpcID),
+    m_mcContributions(trackID, energyInVoxel),
+    m_runVector(0.f, 0.f, 0.f)
 {
 }
 
@@ -92,6 +239,19 @@ inline void LArVoxel::SetTrackID(const int trackid)
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+inline void LArVoxel::AddInputVoxels(const LArVoxel &voxel)
+{
+    if (m_inputVoxelIDs.empty())
+        m_inputVoxelIDs.emplace_back(m_voxelID);
+
+    if (voxel.m_inputVoxelIDs.empty())
+        m_inputVoxelIDs.emplace_back(voxel.m_voxelID);
+    else
+        m_inputVoxelIDs.insert(m_inputVoxelIDs.end(), voxel.m_inputVoxelIDs.begin(), voxel.m_inputVoxelIDs.end());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 class LArVoxelProjection
 {
 public:
@@ -121,6 +281,20 @@ public:
     LArVoxelProjection(const float energy, const float w, const float x, const pandora::HitType &view, const int parentid,
         const int trackid, const unsigned int tpcid);
 
+    /**
+     *  @brief  Constructor
+     *
+     *  @param  energy the energy deposited in the voxel before projection
+     *  @param  w the coordinate in the wire direction after projection
+     *  @param  x the drift coordinate
+     *  @param  view the readout view - typically U, V, or W
+     *  @param  parentid the id of the parent voxel
+     *  @param  mcContributions the true particle energy contributions of the voxel before projection
+     *  @param  tpcid id of the TPC containing the voxel
+     */
+    LArVoxelProjection(const float energy, const float w, const float x, const pandora::HitType &view, const int parentid,
+        const LArMCContributions &mcContributions, const unsigned int tpcid);
+
     float m_energy;          ///< energy deposited in the voxel
     float m_wire;            ///< projected wire coordinate of the voxel
     float m_drift;           ///< drift coordinate (x coordinate of the voxel)
@@ -128,6 +302,9 @@ public:
     int m_parentVoxelID;     ///< id of the parent voxel
     int m_trackID;           ///< true particle responsible for the majority of the energy
     int m_tpcID;             ///< id of the TPC containing the voxel
+    float m_driftSpan;       ///< drift extent of the collinear run represented by the parent voxel, zero if none
+
+    LArMCContributions m_mcContributions; ///< true particle energy contributions
 };
 
 typedef std::vector<LArVoxelProjection> LArVoxelProjectionList;
@@ -136,7 +313,15 @@ typedef std::vector<LArVoxelProjection> LArVoxelProjectionList;
 
 inline LArVoxelProjection::LArVoxelProjection(
     const float energy, const float w, const float x, const pandora::HitType &view, const int parentid, const int trackid) :
-    m_energy(energy), m_wire(w), m_drift(x), m_view(view), m_parentVoxelID(parentid), m_trackID(trackid), m_tpcID(0)
+    m_energy(energy),
+    m_wire(w),
+    m_drift(x),
+    m_view(view),
+    m_parentVoxelID(parentid),
+    m_trackID(trackid),
+    m_tpcID(0),
+    m_driftSpan(0.f),
+    m_mcContributions(trackid, energy)
 {
 }
 
@@ -144,7 +329,31 @@ inline LArVoxelProjection::LArVoxelProjection(
 
 inline LArVoxelProjection::LArVoxelProjection(const float energy, const float w, const float x, const pandora::HitType &view,
     const int parentid, const int trackid, const unsigned int tpcid) :
-    m_energy(energy), m_wire(w), m_drift(x), m_view(view), m_parentVoxelID(parentid), m_trackID(trackid), m_tpcID(tpcid)
+    m_energy(energy),
+    m_wire(w),
+    m_drift(x),
+    m_view(view),
+    m_parentVoxelID(parentid),
+    m_trackID(trackid),
+    m_tpcID(tpcid),
+    m_driftSpan(0.f),
+    m_mcContributions(trackid, energy)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArVoxelProjection::LArVoxelProjection(const float energy, const float w, const float x, const pandora::HitType &view,
+    const int parentid, const LArMCContributions &mcContributions, const unsigned int tpcid) :
+    m_energy(energy),
+    m_wire(w),
+    m_drift(x),
+    m_view(view),
+    m_parentVoxelID(parentid),
+    m_trackID(mcContributions.GetMainTrackID()),
+    m_tpcID(tpcid),
+    m_driftSpan(0.f),
+    m_mcContributions(mcContributions)
 {
 }
 
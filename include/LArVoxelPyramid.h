@@ -0,0 +1,223 @@
+/**
+ *  @file   LArReco/include/LArVoxelPyramid.h
+ *
+ *  @brief  Header file for the multi-resolution voxel pyramid
+ *
+ *  $Log: $
+ */
+#ifndef PANDORA_LAR_VOXEL_PYRAMID_H
+#define PANDORA_LAR_VOXEL_PYRAMID_H 1
+
+#include "Pandora/PandoraInputTypes.h"
+
+#include "LArGrid.h"
+#include "LArVoxel.h"
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+namespace lar_nd_reco
+{
+
+typedef std::vector<size_t> VoxelIndexList;
+
+class LArVoxelLevel
+{
+public:
+    /**
+     *  @brief  Constructor
+     *
+     *  @param  grid The voxelisation grid of this level
+     *  @param  voxels The merged voxels of this level
+     */
+    LArVoxelLevel(const LArGrid &grid, const LArVoxelList &voxels);
+
+    LArGrid m_grid;                         ///< The voxelisation grid of this level
+    LArVoxelList m_voxels;                  ///< The merged voxels of this level
+    std::vector<VoxelIndexList> m_children; ///< The indices of the child voxels in the level below, for each voxel (empty for level 0)
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArVoxelLevel::LArVoxelLevel(const LArGrid &grid, const LArVoxelList &voxels) : m_grid(grid), m_voxels(voxels)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+class LArVoxelPyramid
+{
+public:
+    /**
+     *  @brief  Constructor, with the finest level only
+     *
+     *  @param  grid The voxelisation grid
+     *  @param  voxels The merged voxels from the voxelisation grid
+     *  @param  factor The ratio of the voxel widths of each level and the level below
+     */
+    LArVoxelPyramid(const LArGrid &grid, const LArVoxelList &voxels, const long factor);
+
+    /**
+     *  @brief  Add a coarser level on top of the pyramid, whose grid shares the bottom corner of the level below and whose
+     *          bins each contain factor^3 bins of the level below. Voxels in the same coarse bin and TPC are merged
+     *
+     *  @return Whether the level was added, which fails if the coarse bins no longer fit inside the grid
+     */
+    bool AddLevel();
+
+    /**
+     *  @brief  Get the number of levels, including the finest one
+     *
+     *  @return The number of levels
+     */
+    unsigned int GetNLevels() const;
+
+    /**
+     *  @brief  Get a level of the pyramid, where level 0 is the finest
+     *
+     *  @param  level The level number
+     *
+     *  @return The level
+     */
+    const LArVoxelLevel &GetLevel(const unsigned int level) const;
+
+    /**
+     *  @brief  Get the voxel width of a level, relative to the finest level
+     *
+     *  @param  level The level number
+     *
+     *  @return The relative voxel width
+     */
+    long GetScale(const unsigned int level) const;
+
+    /**
+     *  @brief  Refine a voxel to the indices of the finest level voxels that it contains
+     *
+     *  @param  level The level number of the voxel
+     *  @param  index The index of the voxel in its level
+     *  @param  fineIndices To receive the indices of the finest level voxels
+     */
+    void GetFineVoxelIndices(const unsigned int level, const size_t index, VoxelIndexList &fineIndices) const;
+
+private:
+    long m_factor;                       ///< The ratio of the voxel widths of each level and the level below
+    std::vector<LArVoxelLevel> m_levels; ///< The levels, from the finest to the coarsest
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArVoxelPyramid::LArVoxelPyramid(const LArGrid &grid, const LArVoxelList &voxels, const long factor) : m_factor(factor)
+{
+    if (factor < 2)
+        throw pandora::StatusCodeException(pandora::STATUS_CODE_INVALID_PARAMETER);
+
+    m_levels.emplace_back(LArVoxelLevel(grid, voxels));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline bool LArVoxelPyramid::AddLevel()
+{
+    const LArVoxelLevel &fineLevel = m_levels.back();
+    const LArGrid &fineGrid = fineLevel.m_grid;
+    const LArGrid coarseGrid(
+        fineGrid.m_bottom, fineGrid.m_top, fineGrid.m_binWidths * static_cast<float>(m_factor), fineGrid.m_useMortonOrder);
+
+    if (coarseGrid.m_nBins[0] < 1 || coarseGrid.m_nBins[1] < 1 || coarseGrid.m_nBins[2] < 1)
+        return false;
+
+    LArVoxelLevel coarseLevel(coarseGrid, LArVoxelList());
+    coarseLevel.m_voxels.reserve(fineLevel.m_voxels.size());
+
+    // Index of the coarse voxel for each TPC and coarse voxel ID, keeping the order of first occurrence. A coarse bin straddling a
+    // TPC boundary or the cathode gives one coarse voxel on each side
+    std::map<std::pair<int, long>, size_t> voxelIDToIndex;
+
+    for (size_t i = 0; i < fineLevel.m_voxels.size(); ++i)
+    {
+        const LArVoxel &voxel = fineLevel.m_voxels[i];
+        const LongBin4Array bins = fineGrid.GetBinIndices(voxel.m_voxelID);
+        const long xBin = std::min(bins[0] / m_factor, coarseGrid.m_nBins[0] - 1);
+        const long yBin = std::min(bins[1] / m_factor, coarseGrid.m_nBins[1] - 1);
+        const long zBin = std::min(bins[2] / m_factor, coarseGrid.m_nBins[2] - 1);
+        const long coarseID = coarseGrid.GetTotalBin(xBin, yBin, zBin);
+
+        const std::pair<int, long> coarseKey(voxel.m_tpcID, coarseID);
+        const auto iter = voxelIDToIndex.find(coarseKey);
+        if (iter == voxelIDToIndex.end())
+        {
+            voxelIDToIndex.emplace(coarseKey, coarseLevel.m_voxels.size());
+            LArVoxel coarseVoxel(voxel);
+            if (coarseVoxel.m_inputVoxelIDs.empty())
+                coarseVoxel.m_inputVoxelIDs.emplace_back(voxel.m_voxelID);
+
+            coarseVoxel.m_voxelID = coarseID;
+            coarseVoxel.m_voxelPosVect = coarseGrid.GetPoint(xBin, yBin, zBin);
+            coarseLevel.m_voxels.emplace_back(coarseVoxel);
+            coarseLevel.m_children.emplace_back(VoxelIndexList(1, i));
+            continue;
+        }
+
+        LArVoxel &coarseVoxel = coarseLevel.m_voxels[iter->second];
+        coarseVoxel.SetEnergy(coarseVoxel.m_energyInVoxel + voxel.m_energyInVoxel);
+        coarseVoxel.m_mcContributions.Add(voxel.m_mcContributions);
+        coarseVoxel.SetTrackID(coarseVoxel.m_mcContributions.GetMainTrackID());
+        coarseVoxel.AddInputVoxels(voxel);
+        coarseLevel.m_children[iter->second].emplace_back(i);
+
+        // Keep the longest collinear run, so that the coarse calo hit still covers it
+        if (voxel.m_runVector.GetMagnitudeSquared() > coarseVoxel.m_runVector.GetMagnitudeSquared())
+            coarseVoxel.m_runVector = voxel.m_runVector;
+    }
+
+    m_levels.emplace_back(std::move(coarseLevel));
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline unsigned int LArVoxelPyramid::GetNLevels() const
+{
+    return m_levels.size();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline const LArVoxelLevel &LArVoxelPyramid::GetLevel(const unsigned int level) const
+{
+    if (level >= m_levels.size())
+        throw pandora::StatusCodeException(pandora::STATUS_CODE_OUT_OF_RANGE);
+
+    return m_levels[level];
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline long LArVoxelPyramid::GetScale(const unsigned int level) const
+{
+    long scale(1);
+    for (unsigned int i = 0; i < level; ++i)
+        scale *= m_factor;
+
+    return scale;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArVoxelPyramid::GetFineVoxelIndices(const unsigned int level, const size_t index, VoxelIndexList &fineIndices) const
+{
+    if (level == 0)
+    {
+        fineIndices.emplace_back(index);
+        return;
+    }
+
+    for (const size_t child : this->GetLevel(level).m_children.at(index))
+        this->GetFineVoxelIndices(level - 1, child, fineIndices);
+}
+
+} // namespace lar_nd_reco
+
+#endif
@@ -0,0 +1,231 @@
+/**
+ *  @file   LArReco/include/LArWireProjection.h
+ *
+ *  @brief  Header file for the cached (y,z) to wire coordinate projection
+ *
+ *  $Log: $
+ */
+#ifndef PANDORA_LAR_WIRE_PROJECTION_H
+#define PANDORA_LAR_WIRE_PROJECTION_H 1
+
+#include "Pandora/PandoraInputTypes.h"
+#include "Plugins/LArTransformationPlugin.h"
+
+#include "LArGrid.h"
+#include "LArVoxel.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace lar_nd_reco
+{
+
+/**
+ *  @brief  Cached version of the LArTransformationPlugin YZtoU/V/W projections. The rotational transformation is a sum of
+ *          a y term and a z term, so these are evaluated once using the plugin: either per grid bin, giving lookup tables
+ *          for voxels on the grid lattice, or per unit coordinate for any other (y,z) position
+ */
+class LArWireProjection
+{
+public:
+    /**
+     *  @brief  Constructor for projecting arbitrary (y,z) positions
+     *
+     *  @param  pTransform The transformation plugin of the primary Pandora instance
+     */
+    LArWireProjection(const pandora::LArTransformationPlugin *const pTransform);
+
+    /**
+     *  @brief  Constructor that also builds the lookup tables for the lattice of the voxelisation grid
+     *
+     *  @param  pTransform The transformation plugin of the primary Pandora instance
+     *  @param  grid The voxelisation grid
+     */
+    LArWireProjection(const pandora::LArTransformationPlugin *const pTransform, const LArGrid &grid);
+
+    /**
+     *  @brief  Get the U, V and W wire coordinates of the voxel, using the lookup tables if it lies on the grid lattice
+     *
+     *  @param  voxel The voxel
+     *  @param  u To receive the U wire coordinate
+     *  @param  v To receive the V wire coordinate
+     *  @param  w To receive the W wire coordinate
+     */
+    void Project(const LArVoxel &voxel, float &u, float &v, float &w) const;
+
+    /**
+     *  @brief  Get the U, V and W wire coordinates of the given (y,z) position
+     *
+     *  @param  y The y coordinate
+     *  @param  z The z coordinate
+     *  @param  u To receive the U wire coordinate
+     *  @param  v To receive the V wire coordinate
+     *  @param  w To receive the W wire coordinate
+     */
+    void Project(const float y, const float z, float &u, float &v, float &w) const;
+
+    /**
+     *  @brief  Get the U, V and W wire coordinates of a batch of (y,z) positions
+     *
+     *  @param  yVect The y coordinates
+     *  @param  zVect The z coordinates, with the same size as yVect
+     *  @param  uVect To receive the U wire coordinates
+     *  @param  vVect To receive the V wire coordinates
+     *  @param  wVect To receive the W wire coordinates
+     */
+    void Project(const std::vector<float> &yVect, const std::vector<float> &zVect, std::vector<float> &uVect, std::vector<float> &vVect,
+        std::vector<float> &wVect) const;
+
+private:
+    /**
+     *  @brief  Fill the lookup tables for the grid lattice
+     *
+     *  @param  pTransform The transformation plugin of the primary Pandora instance
+     */
+    void FillTables(const pandora::LArTransformationPlugin *const pTransform);
+
+    const LArGrid *m_pGrid;        ///< The voxelisation grid, or nullptr if there are no lookup tables
+    double m_uY;                   ///< The U coordinate for unit y
+    double m_uZ;                   ///< The U coordinate for unit z
+    double m_vY;                   ///< The V coordinate for unit y
+    double m_vZ;                   ///< The V coordinate for unit z
+    double m_wY;                   ///< The W coordinate for unit y
+    double m_wZ;                   ///< The W coordinate for unit z
+    std::vector<float> m_yLattice; ///< The y position of each grid y bin
+    std::vector<float> m_zLattice; ///< The z position of each grid z bin
+    std::vector<double> m_uYTable; ///< The y term of the U coordinate for each grid y bin
+    std::vector<double> m_uZTable; ///< The z term of the U coordinate for each grid z bin
+    std::vector<double> m_vYTable; ///< The y term of the V coordinate for each grid y bin
+    std::vector<double> m_vZTable; ///< The z term of the V coordinate for each grid z bin
+    std::vector<double> m_wYTable; ///< The y term of the W coordinate for each grid y bin
+    std::vector<double> m_wZTable; ///< The z term of the W coordinate for each grid z bin
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArWireProjection::LArWireProjection(const pandora::LArTransformationPlugin *const pTransform) :
+    m_pGrid(nullptr),
+    m_uY(pTransform->YZtoU(1.0, 0.0)),
+    m_uZ(pTransform->YZtoU(0.0, 1.0)),
+    m_vY(pTransform->YZtoV(1.0, 0.0)),
+    m_vZ(pTransform->YZtoV(0.0, 1.0)),
+    m_wY(pTransform->YZtoW(1.0, 0.0)),
+    m_wZ(pTransform->YZtoW(0.0, 1.0))
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArWireProjection::LArWireProjection(const pandora::LArTransformationPlugin *const pTransform, const LArGrid &grid) :
+    LArWireProjection(pTransform)
+{
+    m_pGrid = &grid;
+    this->FillTables(pTransform);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArWireProjection::FillTables(const pandora::LArTransformationPlugin *const pTransform)
+{
+    const long nYBins(m_pGrid->m_nBins[1]);
+    const long nZBins(m_pGrid->m_nBins[2]);
+
+    m_yLattice.resize(nYBins);
+    m_uYTable.resize(nYBins);
+    m_vYTable.resize(nYBins);
+    m_wYTable.resize(nYBins);
+
+    for (long yBin = 0; yBin < nYBins; ++yBin)
+    {
+        // Use the same float position as the voxels themselves
+        const float y(m_pGrid->GetPoint(0, yBin, 0).GetY());
+        m_yLattice[yBin] = y;
+        m_uYTable[yBin] = pTransform->YZtoU(y, 0.0);
+        m_vYTable[yBin] = pTransform->YZtoV(y, 0.0);
+        m_wYTable[yBin] = pTransform->YZtoW(y, 0.0);
+    }
+
+    m_zLattice.resize(nZBins);
+    m_uZTable.resize(nZBins);
+    m_vZTable.resize(nZBins);
+    m_wZTable.resize(nZBins);
+
+    for (long zBin = 0; zBin < nZBins; ++zBin)
+    {
+        const float z(m_pGrid->GetPoint(0, 0, zBin).GetZ());
+        m_zLattice[zBin] = z;
+        m_uZTable[zBin] = pTransform->YZtoU(0.0, z);
+        m_vZTable[zBin] = pTransform->YZtoV(0.0, z);
+        m_wZTable[zBin] = pTransform->YZtoW(0.0, z);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArWireProjection::Project(const LArVoxel &voxel, float &u, float &v, float &w) const
+{
+    const float y(voxel.m_voxelPosVect.GetY());
+    const float z(voxel.m_voxelPosVect.GetZ());
+
+    if (m_pGrid)
+    {
+        const LongBin4Array bins = m_pGrid->GetBinIndices(voxel.m_voxelID);
+        const long yBin(bins[1]);
+        const long zBin(bins[2]);
+
+        // Only use the tables if the voxel really lies on the lattice of this grid
+        if (yBin >= 0 && yBin < static_cast<long>(m_yLattice.size()) && zBin >= 0 && zBin < static_cast<long>(m_zLattice.size()) &&
+            m_yLattice[yBin] == y && m_zLattice[zBin] == z)
+        {
+            u = static_cast<float>(m_uZTable[zBin] + m_uYTable[yBin]);
+            v = static_cast<float>(m_vZTable[zBin] + m_vYTable[yBin]);
+            w = static_cast<float>(m_wZTable[zBin] + m_wYTable[yBin]);
+            return;
+        }
+    }
+
+    this->Project(y, z, u, v, w);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArWireProjection::Project(const float y, const float z, float &u, float &v, float &w) const
+{
+    u = static_cast<float>(z * m_uZ + y * m_uY);
+    v = static_cast<float>(z * m_vZ + y * m_vY);
+    w = static_cast<float>(z * m_wZ + y * m_wY);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArWireProjection::Project(const std::vector<float> &yVect, const std::vector<float> &zVect, std::vector<float> &uVect,
+    std::vector<float> &vVect, std::vector<float> &wVect) const
+{
+    if (yVect.size() != zVect.size())
+        throw pandora::StatusCodeException(pandora::STATUS_CODE_INVALID_PARAMETER);
+
+    const std::size_t nPoints(yVect.size());
+    uVect.resize(nPoints);
+    vVect.resize(nPoints);
+    wVect.resize(nPoints);
+
+    // Plain loops over contiguous arrays, which the compiler can vectorise
+    const float *const pY(yVect.data());
+    const float *const pZ(zVect.data());
+    float *const pU(uVect.data());
+    float *const pV(vVect.data());
+    float *const pW(wVect.data());
+
+    for (std::size_t i = 0; i < nPoints; ++i)
+        pU[i] = static_cast<float>(pZ[i] * m_uZ + pY[i] * m_uY);
+
+    for (std::size_t i = 0; i < nPoints; ++i)
+        pV[i] = static_cast<float>(pZ[i] * m_vZ + pY[i] * m_vY);
+
+    for (std::size_t i = 0; i < nPoints; ++i)
+        pW[i] = static_cast<float>(pZ[i] * m_wZ + pY[i] * m_wY);
+}
+
+} // namespace lar_nd_reco
+
+#endif
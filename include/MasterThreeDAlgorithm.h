@@ -11,11 +11,19 @@
 #include "Pandora/AlgorithmTool.h"
 #include "Pandora/ExternallyConfiguredAlgorithm.h"
 
+#include "Xml/tinyxml.h"
+
 #include "larpandoracontent/LArControlFlow/MasterAlgorithm.h"
 #include "larpandoracontent/LArControlFlow/MultiPandoraApi.h"
 #include "larpandoracontent/LArObjects/LArCaloHit.h"
 
+#include "LArObjectPool.h"
+#include "LArSliceFile.h"
+
+#include <chrono>
+#include <map>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace lar_content
 {
@@ -31,11 +39,23 @@ public:
     /**
      *  @brief  Default constructor
      */
-    MasterThreeDAlgorithm() = default;
+    MasterThreeDAlgorithm();
+
+    /**
+     *  @brief  Destructor
+     */
+    ~MasterThreeDAlgorithm();
 
 protected:
     pandora::StatusCode Run();
 
+    /**
+     *  @brief  Reset all worker instances, including the extra slice worker instances of the pool
+     *
+     *  @return status code
+     */
+    pandora::StatusCode Reset();
+
     /**
      *  @brief  Run the event slicing procedures, dividing available hits up into distinct 3D regions
      *
@@ -47,7 +67,113 @@ protected:
     pandora::StatusCode RunSlicing(const VolumeIdToHitListMap &volumeIdToHitListMap, SliceVector &sliceVector) const;
 
     /**
-     *  @brief  Create a pandora worker instance to handle a single LArTPC
+     *  @brief  Write the slices of the event to the slice file, as the ids of their hits, which are the parent addresses of the
+     *          master instance hits set by the application
+     *
+     *  @param  sliceVector the slice vector
+     *
+     *  @return status code
+     */
+    pandora::StatusCode WriteSlices(const SliceVector &sliceVector);
+
+    /**
+     *  @brief  Read the slices of the event from the slice file, instead of running the slicing
+     *
+     *  @param  sliceVector to receive the populated slice vector, of master instance hits
+     *
+     *  @return status code
+     */
+    pandora::StatusCode ReadSlices(SliceVector &sliceVector);
+
+    /**
+     *  @brief  Run the per-LArTPC cosmic-ray reconstruction. The hits are copied to the workers in volume id order on this thread,
+     *          then the workers with hits process their events concurrently, on up to m_nCRWorkerThreads threads
+     *
+     *  @param  volumeIdToHitListMap the volume id to hit list map
+     *
+     *  @return status code
+     */
+    pandora::StatusCode RunCosmicRayReconstruction(const VolumeIdToHitListMap &volumeIdToHitListMap) const;
+
+    /**
+     *  @brief  Run the neutrino and cosmic-ray reconstruction of each slice. With a pool of slice worker instances, each round of
+     *          slices is copied to the pool on this thread, processed concurrently, then collected in slice order. The workers are
+     *          not reset between slices, so each pool worker carries over different earlier slices than a single worker would, and
+     *          the hypotheses are not guaranteed to match. Once the event is over its time budget, the slices with more than
+     *          m_budgetMaxSliceHits hits are skipped
+     *
+     *  @param  sliceVector the slice vector
+     *  @param  nuSliceHypotheses to receive the neutrino slice hypotheses, in slice order
+     *  @param  crSliceHypotheses to receive the cosmic-ray slice hypotheses, in slice order
+     *
+     *  @return status code
+     */
+    pandora::StatusCode RunSliceReconstruction(
+        SliceVector &sliceVector, SliceHypotheses &nuSliceHypotheses, SliceHypotheses &crSliceHypotheses) const;
+
+    /**
+     *  @brief  Whether the event has run out of its time budget. The first time this happens in an event, the event is flagged
+     *          and the stage about to be degraded is reported
+     *
+     *  @param  stageName the name of the next stage, which will be skipped or simplified
+     *
+     *  @return boolean
+     */
+    bool IsOverBudget(const std::string &stageName) const;
+
+    /**
+     *  @brief  Copy a list of calo hits from the master instance to a worker instance in a single pass, reusing one set of hit
+     *          parameters. The parent address of each copy is the master instance hit. If mc particles are passed to the worker
+     *          instances, the hit to mc particle relationships are copied too, along with the mc particles they need
+     *
+     *  @param  pPandora the address of the worker instance
+     *  @param  caloHitList the list of master instance calo hits
+     *
+     *  @return status code
+     */
+    pandora::StatusCode CopyCaloHits(const pandora::Pandora *const pPandora, const pandora::CaloHitList &caloHitList) const;
+
+    /**
+     *  @brief  Copy mc particles from the master instance to a worker instance, with all their ancestors, skipping those already
+     *          copied to the worker instance in this event
+     *
+     *  @param  pPandora the address of the worker instance
+     *  @param  mcParticleSet the master instance mc particles contributing to the calo hits copied to the worker instance
+     *
+     *  @return status code
+     */
+    pandora::StatusCode CopyMCParticles(
+        const pandora::Pandora *const pPandora, const std::unordered_set<const pandora::MCParticle *> &mcParticleSet) const;
+
+    /**
+     *  @brief  Process the event of a worker instance, adding its time to the profile if the profile is enabled
+     *
+     *  @param  pWorkerInstance the address of the worker instance
+     *
+     *  @return status code
+     */
+    static pandora::StatusCode ProcessWorkerInstance(const pandora::Pandora *const pWorkerInstance);
+
+    /**
+     *  @brief  Process the events of a number of worker instances concurrently, each of which only touches its own objects
+     *
+     *  @param  workerInstances the worker instances, in the order in which to start them
+     *  @param  nThreads the max number of threads (0 = the CPUs this process may run on, shared between any forked processes)
+     *
+     *  @return status code, which is the first failure in the order of the worker instances
+     */
+    static pandora::StatusCode ProcessWorkerInstances(const PandoraInstanceList &workerInstances, const unsigned int nThreads);
+
+    /**
+     *  @brief  Get the number of CPUs this process may run on, which in a batch slot can be fewer than the CPUs of the node
+     *
+     *  @return the number of CPUs, at least one
+     */
+    static unsigned int GetNAvailableCPUs();
+
+    /**
+     *  @brief  Create a pandora worker instance to handle a single LArTPC. Unlike the multi-LArTPC workers, this instance is not
+     *          registered as a daughter of the primary instance and must be deleted by the caller
      *
      *  @param  larTPC the lar tpc
      *  @param  gapList the gap list
@@ -73,10 +199,40 @@ protected:
         const std::string &settingsFile, const std::string &name) const;
 
     /**
-     *  @brief  Initialize pandora worker instances
+     *  @brief  Configure a pandora worker instance from the in-memory copy of a settings file, reporting the time taken if
+     *          m_printOverallRecoStatus is set
+     *
+     *  @param  pPandora the address of the pandora worker instance
+     *  @param  settingsFile the pandora settings file
+     */
+    void ReadWorkerSettings(const pandora::Pandora *const pPandora, const std::string &settingsFile) const;
+
+    /**
+     *  @brief  Get the parsed document for a settings file, which is loaded and parsed only once per process
+     *
+     *  @param  settingsFile the pandora settings file
+     *  @param  shouldPrintTime whether to report the time taken to parse the settings file
+     *
+     *  @return the parsed settings document
+     */
+    static const pandora::TiXmlDocument &GetSettingsDocument(const std::string &settingsFile, const bool shouldPrintTime);
+
+    /**
+     *  @brief  Initialize pandora worker instances, when reading the settings if the geometry is already available, or else on the
+     *          first event. The per-LArTPC cosmic-ray worker instances are instead created on first use
      */
     pandora::StatusCode InitializeWorkerInstances();
 
+    /**
+     *  @brief  Create the cosmic-ray worker instances for the LArTPCs with hits that do not yet have one, and release those that
+     *          have been idle for too many events
+     *
+     *  @param  volumeIdToHitListMap the volume id to hit list map
+     *
+     *  @return status code
+     */
+    pandora::StatusCode UpdateCosmicRayWorkerInstances(const VolumeIdToHitListMap &volumeIdToHitListMap);
+
     /**
      *  @brief  Get the mapping from lar tpc volume id to lists of all hits, and truncated hits
      *
@@ -87,6 +243,29 @@ protected:
     pandora::StatusCode GetVolumeIdToHitListMap(VolumeIdToHitListMap &volumeIdToHitListMap) const;
 
     pandora::StatusCode ReadSettings(const pandora::TiXmlHandle xmlHandle);
+
+    typedef std::map<unsigned int, const pandora::Pandora *> VolumeIdToPandoraMap;
+    typedef std::map<unsigned int, unsigned int> VolumeIdToCountMap;
+    typedef std::chrono::steady_clock::time_point TimePoint;
+    typedef std::unordered_map<const pandora::Pandora *, std::unordered_set<const pandora::MCParticle *>> WorkerMCMap;
+
+    VolumeIdToPandoraMap m_crWorkerInstanceMap; ///< The cosmic-ray worker instances created so far, keyed on their lar tpc volume id
+    VolumeIdToCountMap m_crWorkerIdleEventsMap; ///< The number of consecutive events without hits for each cosmic-ray worker instance
+    unsigned int m_crWorkerIdleEventLimit;      ///< Release cosmic-ray worker instances idle for this many events (0 = never)
+    unsigned int m_nCRWorkerThreads;            ///< The max number of threads for the cosmic-ray workers (0 = shared available CPUs)
+    unsigned int m_nSliceWorkers;               ///< The number of nu and cr slice worker instances (1 = serial reference)
+    PandoraInstanceList m_sliceNuWorkerPool;    ///< The pool of nu slice worker instances, starting with m_pSliceNuWorkerInstance
+    PandoraInstanceList m_sliceCRWorkerPool;    ///< The pool of cr slice worker instances, starting with m_pSliceCRWorkerInstance
+    LArPooledCaloHitFactory m_hitFactory;       ///< The factory for the calo hits copied to the worker instances
+    LArPooledMCParticleFactory m_mcFactory;     ///< The factory for the mc particles copied to the worker instances
+    mutable WorkerMCMap m_workerMCParticles;    ///< The master instance mc particles copied to each worker instance in this event
+    float m_eventTimeBudget;                    ///< The wall-clock time budget of each event, in seconds (0 = no budget)
+    unsigned int m_budgetMaxSliceHits;          ///< Once over budget, only reconstruct slices with at most this many hits
+    TimePoint m_eventStartTime;                 ///< The time at which the reconstruction of the current event started
+    int m_eventCount;                           ///< The number of events run so far, less one
+    std::string m_sliceOutputFileName;          ///< The file to write the slices of each event to, if any
+    std::string m_sliceInputFileName;           ///< The file to read the event slices from, instead of running slicing and cosmic-ray reco
+    LArSliceFile m_sliceFile;                   ///< The slice file being written or read
 };
 
 } // namespace lar_content
@@ -17,13 +17,26 @@
 #include "TGeoManager.h"
 #include "TGeoNode.h"
 
+#include <sys/types.h>
+
+#include <chrono>
+#include <fstream>
+
+#include "LArEventHitVolumes.h"
+#include "LArEventHitVoxels.h"
+#include "LArGeometryCache.h"
 #include "LArGrid.h"
 #include "LArHitInfo.h"
 #include "LArNDGeomSimple.h"
+#include "LArProcessShard.h"
 #include "LArSED.h"
+#include "LArServerJob.h"
+#include "LArSubEvent.h"
 #include "LArSP.h"
 #include "LArSPMC.h"
 #include "LArVoxel.h"
+#include "LArVoxelPyramid.h"
+#include "LArWireProjection.h"
 
 namespace pandora
 {
@@ -35,7 +48,7 @@ class Pandora;
 namespace lar_nd_reco
 {
 
-typedef std::map<int, float> MCParticleEnergyMap;
+typedef std::map<long, float> MCParticleEnergyMap;
 typedef std::vector<LArVoxel> LArVoxelList;
 
 /**
@@ -65,8 +78,10 @@ public:
                                  ///< and/or geometry information
     std::string m_inputTreeName; ///< The optional name of the event TTree
 
-    std::string m_geomFileName;    ///< The ROOT file name containing the TGeoManager info
-    std::string m_geomManagerName; ///< The name of the TGeoManager
+    std::string m_geomFileName;      ///< The ROOT file name containing the TGeoManager info
+    std::string m_geomManagerName;   ///< The name of the TGeoManager
+    std::string m_geomCacheFileName; ///< The optional cache file of the resolved TPC volumes, rebuilt if the geometry changes
+    bool m_onlyWriteGeomCache;       ///< Only (re)build the geometry cache file, without processing events
 
     std::string m_geometryVolName;  ///< The name of the Geant4 detector placement volume
     std::string m_sensitiveDetName; ///< The name of the Geant4 sensitive hit detector
@@ -86,17 +101,31 @@ public:
     bool m_shouldPerformSliceId;        ///< Whether to identify slices and select most appropriate pfos
     bool m_printOverallRecoStatus;      ///< Whether to print current operation status messages
 
-    int m_nEventsToSkip;       ///< The number of events to skip
-    int m_maxMergedVoxels;     ///< The max number of merged voxels to process (default all)
-    int m_minNSpacePoints;     ///< The minimum number of space points for processing an event (default = 2)
-    float m_minVoxelMipEquivE; ///< The minimum required voxel equivalent MIP energy (default = 0.3)
+    int m_nProcesses;            ///< The number of child processes sharing the events after initialisation (default 1 = no children)
+    bool m_blockPartitionEvents; ///< Give each child process a contiguous block of events, instead of every m_nProcesses'th event
+    int m_processIndex;          ///< The index of this child process, or -1 if the events are not shared
+
+    std::string m_serverSpoolName; ///< The spool directory or control FIFO of the input files to process as a persistent server
+    std::string m_profileFileName; ///< The optional csv file of the time of each worker instance event and profiled algorithm
+
+    int m_nEventsToSkip;            ///< The number of events to skip
+    int m_maxMergedVoxels;          ///< The max number of merged voxels to process (default all)
+    int m_maxVoxelCoarsening;       ///< The max number of coarser voxel levels for events above m_maxMergedVoxels (default 0 = skip them)
+    int m_voxelPyramidFactor;       ///< The voxel width ratio between each coarser voxel level and the level below (default = 2)
+    int m_minNSpacePoints;          ///< The minimum number of space points for processing an event (default = 2)
+    float m_minVoxelMipEquivE;      ///< The minimum required voxel equivalent MIP energy (default = 0.3)
+    float m_spProjectionMergeWidth; ///< The (wire, drift) cell width (cm) for merging space point 2D projections (default 0 = no merging)
+    int m_maxCollinearRun;          ///< The max number of voxels in a collinear run represented by its end voxels (default 0 = off)
+    float m_subEventTimeGap;        ///< Split each spill into sub-events at gaps of at least this size in the space point times (0 = off)
+    int m_minSubEventSPs;           ///< The min number of space points of a sub-event, or it joins its nearest neighbour in time
 
     bool m_use3D;     ///< Create 3D LArCaloHits
     bool m_useLArTPC; ///< Create LArTPC LArCaloHits with u,v,w views
 
-    float m_voxelWidth;  ///< Voxel box width (cm)
-    float m_lengthScale; ///< The scaling factor to set all lengths to cm
-    float m_energyScale; ///< The scaling factor to set all energies to GeV
+    float m_voxelWidth;         ///< Voxel box width (cm)
+    bool m_useMortonVoxelOrder; ///< Number voxels along a Z-order (Morton) curve and create their hits in that order
+    float m_lengthScale;        ///< The scaling factor to set all lengths to cm
+    float m_energyScale;        ///< The scaling factor to set all energies to GeV
 
     const float m_mm2cm{0.1f};          ///< mm to cm conversion
     const float m_MeV2GeV{1e-3};        ///< Geant4 MeV to GeV conversion
@@ -112,6 +141,8 @@ inline Parameters::Parameters() :
     m_inputTreeName(""),
     m_geomFileName(""),
     m_geomManagerName(""),
+    m_geomCacheFileName(""),
+    m_onlyWriteGeomCache(false),
     m_geometryVolName(""),
     m_sensitiveDetName(""),
     m_useModularGeometry(false),
@@ -125,13 +156,25 @@ inline Parameters::Parameters() :
     m_shouldRunCosmicRecoOption(true),
     m_shouldPerformSliceId(true),
     m_printOverallRecoStatus(false),
+    m_nProcesses(1),
+    m_blockPartitionEvents(false),
+    m_processIndex(-1),
+    m_serverSpoolName(""),
+    m_profileFileName(""),
     m_nEventsToSkip(0),
     m_maxMergedVoxels(-1),
+    m_maxVoxelCoarsening(0),
+    m_voxelPyramidFactor(2),
     m_minNSpacePoints(2),
     m_minVoxelMipEquivE(0.3f),
+    m_spProjectionMergeWidth(0.f),
+    m_maxCollinearRun(0),
+    m_subEventTimeGap(0.f),
+    m_minSubEventSPs(2),
     m_use3D(true),
     m_useLArTPC(true),
     m_voxelWidth(0.4f),
+    m_useMortonVoxelOrder(false),
     m_lengthScale(1.0f),
     m_energyScale(1.0f)
 {
@@ -140,6 +183,38 @@ inline Parameters::Parameters() :
 //------------------------------------------------------------------------------------------------------------------------------------------
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+/**
+ *  @brief  A child process sharing the events
+ */
+class LArChildProcess
+{
+public:
+    int m_shardIndex;                                  ///< The index of the child process
+    pid_t m_pid;                                       ///< The process id
+    int m_resultFd;                                    ///< The read end of the pipe giving the number of events of the child
+    std::chrono::steady_clock::time_point m_startTime; ///< The time at which the child was forked
+};
+
+typedef std::vector<LArChildProcess> LArChildProcessList;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  A sub-event of a spill, made of the space points in a window of time
+ */
+class LArTimeWindow
+{
+public:
+    float m_startTime;               ///< The time of the earliest space point
+    float m_endTime;                 ///< The time of the latest space point
+    std::vector<size_t> m_spIndices; ///< The indices of the input space points, in input order
+};
+
+typedef std::vector<LArTimeWindow> LArTimeWindowList;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 /**
  *  @brief  Create the detector geometry based on the C++ root file
  *
@@ -173,9 +248,158 @@ void RecursiveGeometrySearch(TGeoManager *pSimGeom, const std::string &targetNam
  *  @param  pVolMatrix matrix required to convert TPC coordinates to world
  *  @param  targetNode pointer to the TPC geometry node
  *  @param  tpcNumber the number for the TPC volume
+ *  @param  geomCache To receive the resolved box of the TPC
  */
 void MakePandoraTPC(const pandora::Pandora *const pPrimaryPandora, const Parameters &parameters, LArNDGeomSimple &geom,
-    const std::unique_ptr<TGeoHMatrix> &pVolMatrix, const TGeoNode *targetNode, const unsigned int tpcNumber);
+    const std::unique_ptr<TGeoHMatrix> &pVolMatrix, const TGeoNode *targetNode, const unsigned int tpcNumber, LArGeometryCache &geomCache);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Create and register a tpc in pandora from its resolved box
+ *
+ *  @param  pPrimaryPandora The address of the primary pandora instance
+ *  @param  geom Simple representation of the geometry for assigning TPC numbers
+ *  @param  tpc The resolved box of the TPC
+ */
+void MakePandoraTPC(const pandora::Pandora *const pPrimaryPandora, LArNDGeomSimple &geom, const LArCachedTPC &tpc);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Get the checksum of the geometry file and of the options that determine its TPC volumes
+ *
+ *  @param  parameters The application parameters
+ *  @param  checksum To receive the checksum
+ *
+ *  @return Whether the geometry file could be read
+ */
+bool GetGeometryChecksum(const Parameters &parameters, std::uint64_t &checksum);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Whether the settings configure a validation algorithm that writes its trees to fixed file names when the process
+ *          ends, reporting each such algorithm. Several processes would all write the same files, and a server would collect
+ *          the output of every job in them
+ *
+ *  @param  settingsFile The Pandora settings file
+ *
+ *  @return Whether any validation algorithm writes trees to fixed file names
+ */
+bool WritesFixedValidationOutput(const std::string &settingsFile);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Fork the child processes that share the events, once all of the initialisation has been done. The children
+ *          inherit the initialised state, which is shared with the parent until written to
+ *
+ *  @param  parameters The application parameters
+ *  @param  childProcesses To receive the child processes, in the parent process
+ *  @param  resultFd To receive the write end of the pipe for reporting the number of events, in a child process
+ *
+ *  @return The index of the child process, or -1 in the parent process
+ */
+int ForkChildProcesses(const Parameters &parameters, LArChildProcessList &childProcesses, int &resultFd);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Wait for the child processes to finish, reporting the throughput of each of them
+ *
+ *  @param  parameters The application parameters
+ *  @param  childProcesses The child processes
+ *
+ *  @return The error number, which is 0 if all of the requested child processes succeeded
+ */
+int WaitForChildProcesses(const Parameters &parameters, const LArChildProcessList &childProcesses);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Report the number of events of this child process to the parent process
+ *
+ *  @param  resultFd The write end of the pipe for reporting the number of events
+ */
+void ReportChildProcessEvents(const int resultFd);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Get the input events to process, which are the share of this child process if the events are shared
+ *
+ *  @param  parameters The application parameters
+ *  @param  startEvt The first input event of the whole job
+ *  @param  endEvt The end (one past the last) input event of the whole job
+ *  @param  firstEvt To receive the first input event to process
+ *  @param  lastEvt To receive the end of the input events to process
+ *  @param  eventStride To receive the step between the input events to process
+ */
+void GetProcessEventRange(
+    const Parameters &parameters, const int startEvt, const int endEvt, int &firstEvt, int &lastEvt, int &eventStride);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Run as a persistent server, processing the events of each queued input file with the same initialised pandora
+ *          instances. Only the per-event and per-file state is reset between the files, and a completion marker is written
+ *          next to the output file of each job. The hierarchy analysis reads its event numbers from the input file of each job,
+ *          which replaces its EventFileName setting, and writes its tree to the output file of the job
+ *
+ *  @param  parameters The application parameters
+ *  @param  pPrimaryPandora The address of the primary pandora instance
+ *  @param  geom Simple representation of the geometry for assigning TPC numbers
+ *
+ *  @return The error number, which is 0 if all of the jobs succeeded
+ */
+int RunServer(const Parameters &parameters, const pandora::Pandora *const pPrimaryPandora, const LArNDGeomSimple &geom);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Wait for the next job in the server spool directory, which is a "<name>.job" file containing the input and output
+ *          file names. Jobs are taken in name order and claimed by renaming them to "<name>.job.running"
+ *
+ *  @param  parameters The application parameters
+ *  @param  jobFileName To receive the name of the claimed job file
+ *  @param  inputFileName To receive the input file name
+ *  @param  outputFileName To receive the output file name
+ *
+ *  @return Whether a job was found, which is false once a "stop" file appears in the spool directory
+ */
+bool GetNextSpoolServerJob(
+    const Parameters &parameters, std::string &jobFileName, std::string &inputFileName, std::string &outputFileName);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Wait for the next job on the server control FIFO, which is a line containing the input and output file names
+ *
+ *  @param  parameters The application parameters
+ *  @param  controlFifo The control FIFO stream, which is (re)opened when needed
+ *  @param  inputFileName To receive the input file name
+ *  @param  outputFileName To receive the output file name
+ *
+ *  @return Whether a job was found, which is false once a "stop" line is read
+ */
+bool GetNextFifoServerJob(
+    const Parameters &parameters, std::ifstream &controlFifo, std::string &inputFileName, std::string &outputFileName);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Write the completion marker of a server job, "<output>.done", containing the input and output file names, the
+ *          status, the number of events and the processing time
+ *
+ *  @param  inputFileName The input file name
+ *  @param  outputFileName The output file name
+ *  @param  succeeded Whether the job succeeded
+ *  @param  nEvents The number of events processed
+ *  @param  seconds The processing time (s)
+ */
+void WriteServerJobMarker(
+    const std::string &inputFileName, const std::string &outputFileName, const bool succeeded, const int nEvents, const double seconds);
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
@@ -209,6 +433,68 @@ void ProcessSPEvents(const Parameters &parameters, const pandora::Pandora *const
  */
 void CreateSPMCParticles(const LArSPMC &larspmc, const pandora::Pandora *const pPrimaryPandora, const Parameters &parameters);
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Split the space points of a spill into sub-events, wherever consecutive space point times are at least the sub-event
+ *          time gap apart. A window with fewer than the min number of space points joins its nearest neighbour in time, and space
+ *          points without a valid time join the latest window
+ *
+ *  @param  larsp The LArSP data object
+ *  @param  parameters The application parameters
+ *  @param  timeWindows To receive the sub-events in time order, or nothing if the spill is reconstructed as one event
+ */
+void MakeSpacePointTimeWindows(const LArSP &larsp, const Parameters &parameters, LArTimeWindowList &timeWindows);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Merge the space points of an event that lie in the same cubic cell, doubling the cell width (starting from the
+ *          voxel width) each time, until there are no more than the maximum number of merged voxels or the maximum number
+ *          of doublings is reached. Merged space points have the summed charge at the charge-weighted mean position
+ *
+ *  @param  larsp The LArSP data object
+ *  @param  inputIndices The input space points of the event, if it is a sub-event of the spill, or empty for all space points
+ *  @param  parameters The application parameters
+ *  @param  spIndices To receive the index of the largest charge input space point of each merged space point, used for the truth
+ *  @param  xVect To receive the x coordinates of the merged space points
+ *  @param  yVect To receive the y coordinates of the merged space points
+ *  @param  zVect To receive the z coordinates of the merged space points
+ *  @param  chargeVect To receive the charges of the merged space points
+ *  @param  cellWidth To receive the cell width that was used
+ *
+ *  @return Whether the event now has few enough space points to be processed
+ */
+bool CoarsenSpacePoints(const LArSP &larsp, const std::vector<size_t> &inputIndices, const Parameters &parameters,
+    std::vector<size_t> &spIndices, std::vector<float> &xVect, std::vector<float> &yVect, std::vector<float> &zVect,
+    std::vector<float> &chargeVect, float &cellWidth);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Quantise a projected (wire or drift) position to the centre of its cell
+ *
+ *  @param  position The projected position
+ *  @param  width The cell width
+ *
+ *  @return The centre of the cell containing the position
+ */
+float QuantiseProjection(const float position, const float width);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Merge the quantised 2D projections of space points in each view and create their pandora calohits
+ *
+ *  @param  projections The quantised U, V and W projections of the space points
+ *  @param  pPrimaryPandora The address of the primary pandora instance
+ *  @param  parameters The application parameters
+ *  @param  cellWidth The calohit cell width
+ *  @param  hitCounter Reference to keep track of the number of hits
+ */
+void MakeCaloHitsFromSpacePointProjections(const LArVoxelProjectionList &projections, const pandora::Pandora *const pPrimaryPandora,
+    const Parameters &parameters, const float cellWidth, int &hitCounter);
+
 #ifdef USE_EDEPSIM
 //------------------------------------------------------------------------------------------------------------------------------------------
 
@@ -308,16 +594,35 @@ LArGrid MakeVoxelisationGrid(const LArNDGeomSimple &geom, const Parameters &para
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 /**
- *  @brief  Make voxels from a given Geant4 energy deposition step
+ *  @brief  Make voxels from a list of Geant4 energy deposition steps. The steps are clipped against the voxelisation grid, and the
+ *          TPC boxes of a modular geometry, a batch of steps at a time with the batched LArBox::Intersect
  *
- *  @param  hitInfo Information about the hit
+ *  @param  hitInfoList Information about the hits
  *  @param  grid Voxelisation grid
  *  @param  parameters The application parameters
  *  @param  simple geometry information
  *
- *  @return vector of LArVoxels
+ *  @return vector of LArVoxels, in the order of the steps
  */
-LArVoxelList MakeVoxels(const LArHitInfo &hitInfo, const LArGrid &grid, const Parameters &parameters, const LArNDGeomSimple &geom);
+LArVoxelList MakeVoxels(const LArHitInfoList &hitInfoList, const LArGrid &grid, const Parameters &parameters, const LArNDGeomSimple &geom);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Step along a ray through the voxelisation grid, adding a voxel for each grid bin that it crosses
+ *
+ *  @param  ray The ray, starting at the first point to voxelise; its origin is moved along as voxels are made
+ *  @param  pathLength The path length (cm) along the ray to voxelise
+ *  @param  hitLength The total length (cm) of the original hit segment, used to share out its energy
+ *  @param  hitEnergy The total energy (GeV) of the original hit segment
+ *  @param  trackID The Geant4 ID of the (main) contributing particle
+ *  @param  tpcID The ID of the TPC containing this part of the segment
+ *  @param  grid Voxelisation grid
+ *  @param  parameters The application parameters
+ *  @param  voxelList The list of voxels to append to
+ */
+void AddSegmentVoxels(LArRay &ray, const float pathLength, const float hitLength, const float hitEnergy, const int trackID,
+    const unsigned int tpcID, const LArGrid &grid, const Parameters &parameters, LArVoxelList &voxelList);
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
@@ -332,14 +637,56 @@ LArVoxelList MergeSameVoxels(const LArVoxelList &voxelList);
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+/**
+ *  @brief  Compress runs of neighbouring voxels of the same main track that lie along a straight line, such as those from long
+ *          tracks. Each run of up to m_maxCollinearRun voxels is represented by its end voxels, which are shared with the
+ *          adjacent runs; every other voxel in the run adds its energy and true particle contributions to the nearest end voxel.
+ *          Each end voxel keeps the IDs of the input voxels it represents and the vector spanning them, which its calo hits are
+ *          widened along. Runs are found along the input voxel order, so this must be used before any sorting
+ *
+ *  @param  voxelList the merged voxels, in the order they were made along the hit segments
+ *  @param  grid the voxelisation grid
+ *  @param  parameters the application parameters
+ *
+ *  @return the compressed voxels
+ */
+LArVoxelList CompressCollinearVoxels(const LArVoxelList &voxelList, const LArGrid &grid, const Parameters &parameters);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Coarsen the merged voxels of an event by building the levels of a voxel pyramid, until a level has no more than the
+ *          maximum number of merged voxels or the maximum number of coarser levels is reached
+ *
+ *  @param  grid the original voxelisation grid
+ *  @param  parameters the application parameters
+ *  @param  mergedVoxels the merged voxels, which are replaced by the coarsened voxels
+ *  @param  voxelWidth to receive the voxel width that was used
+ *
+ *  @return whether the event now has few enough voxels to be processed
+ */
+bool CoarsenEventVoxels(const LArGrid &grid, const Parameters &parameters, LArVoxelList &mergedVoxels, float &voxelWidth);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Sort voxels by increasing voxel ID, which follows the space-filling curve when using Morton voxel IDs
+ *
+ *  @param  voxelList The list (vector) of voxels to sort
+ */
+void SortVoxelsByID(LArVoxelList &voxelList);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 /**
  *  @brief  Combine energies for voxel projections with the same (wire,drift) position
  *
  *  @param  hits The unmerged list (vector) of voxel projections
+ *  @param  mergeAcrossTPCs Whether projections from different TPCs are merged, keeping the TPC of the first one
  *
  *  @return vector of merged LArVoxelProjections
  */
-LArVoxelProjectionList MergeSameProjections(const LArVoxelProjectionList &hits);
+LArVoxelProjectionList MergeSameProjections(const LArVoxelProjectionList &hits, const bool mergeAcrossTPCs);
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
@@ -347,16 +694,52 @@ LArVoxelProjectionList MergeSameProjections(const LArVoxelProjectionList &hits);
  *  @brief  Create the pandora calohits from voxels
  *
  *  @param  voxels the voxels to use to create the hits
+ *  @param  wireProjection the cached projection of voxel positions to wire coordinates
  *  @param  mcEnergyMap map of mc particle to its energy
  *  @param  pPrimaryPandora address of the primary pandora instance
  *  @param  parameters the application parameters
  *  @param  hitCounter reference to keep track of the number of hits
  */
-void MakeCaloHitsFromVoxels(const LArVoxelList &voxels, const MCParticleEnergyMap &mcEnergyMap,
+void MakeCaloHitsFromVoxels(const LArVoxelList &voxels, const LArWireProjection &wireProjection, const MCParticleEnergyMap &mcEnergyMap,
     const pandora::Pandora *const pPrimaryPandora, const Parameters &parameters, int &hitCounter);
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+/**
+ *  @brief  Create a calo hit in the primary pandora instance and record its LArTPC volume for the master algorithm
+ *
+ *  @param  pPrimaryPandora address of the primary pandora instance
+ *  @param  caloHitParameters the calo hit parameters, whose parent address is the hit counter
+ *  @param  larCaloHitFactory the factory for the LArCaloHits
+ */
+void CreateLArCaloHit(const pandora::Pandora *const pPrimaryPandora, const lar_content::LArCaloHitParameters &caloHitParameters,
+    const lar_content::LArCaloHitFactory &larCaloHitFactory);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Process the event of the primary pandora instance and reset it, adding the event to the profile if the profile is enabled
+ *
+ *  @param  pPrimaryPandora address of the primary pandora instance
+ *  @param  nHits the number of calo hits of the event
+ */
+void ProcessPrimaryEvent(const pandora::Pandora *const pPrimaryPandora, const int nHits);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Set the relations between the latest calo hit and each of the MC particles contributing to its energy
+ *
+ *  @param  mcContributions the true particle energy contributions of the hit
+ *  @param  mcEnergyMap map of true particle to the energy
+ *  @param  pPrimaryPandora address of the primary pandora instance
+ *  @param  hitCounter the parent address of the calo hit
+ */
+void SetCaloHitMCParticleRelationships(const LArMCContributions &mcContributions, const MCParticleEnergyMap &mcEnergyMap,
+    const pandora::Pandora *const pPrimaryPandora, const int hitCounter);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 /**
  *  @brief  Return the fraction of the MC particle energy in this voxel
  *
@@ -366,7 +749,7 @@ void MakeCaloHitsFromVoxels(const LArVoxelList &voxels, const MCParticleEnergyMa
  *
  *  @return fraction of true particle energy in the voxel as a float
  */
-float GetMCEnergyFraction(const MCParticleEnergyMap &mcEnergyMap, const float voxelE, const int trackID);
+float GetMCEnergyFraction(const MCParticleEnergyMap &mcEnergyMap, const float voxelE, const long trackID);
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
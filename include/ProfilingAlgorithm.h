@@ -0,0 +1,38 @@
+/**
+ *  @file   include/ProfilingAlgorithm.h
+ *
+ *  @brief  Header file for the algorithm timing its daughter algorithms.
+ *
+ *  $Log: $
+ */
+#ifndef LAR_PROFILING_ALGORITHM_H
+#define LAR_PROFILING_ALGORITHM_H 1
+
+#include "Pandora/Algorithm.h"
+
+namespace lar_content
+{
+
+/**
+ *  @brief  ProfilingAlgorithm class. Runs the algorithms of its algorithms list in turn, as daughter algorithms, and adds the wall
+ *          and cpu time of each to the LArProfile when the profile is enabled
+ */
+class ProfilingAlgorithm : public pandora::Algorithm
+{
+public:
+    /**
+     *  @brief  Default constructor
+     */
+    ProfilingAlgorithm();
+
+private:
+    pandora::StatusCode Run();
+    pandora::StatusCode ReadSettings(const pandora::TiXmlHandle xmlHandle);
+
+    pandora::StringVector m_algorithmNames; ///< The names of the daughter algorithms
+    pandora::StringVector m_algorithmTypes; ///< The types of the daughter algorithms, which name their profile entries
+};
+
+} // namespace lar_content
+
+#endif // #ifndef LAR_PROFILING_ALGORITHM_H
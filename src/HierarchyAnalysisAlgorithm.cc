@@ -9,6 +9,11 @@
 #include "Pandora/AlgorithmHeaders.h"
 
 #include "HierarchyAnalysisAlgorithm.h"
+#include "LArEventBudget.h"
+#include "LArEventHitVoxels.h"
+#include "LArProcessShard.h"
+#include "LArServerJob.h"
+#include "LArSubEvent.h"
 
 #include "larpandoracontent/LArHelpers/LArClusterHelper.h"
 #include "larpandoracontent/LArHelpers/LArPfoHelper.h"
@@ -23,6 +28,8 @@ namespace lar_content
 
 HierarchyAnalysisAlgorithm::HierarchyAnalysisAlgorithm() :
     m_count{-1},
+    m_jobNumber{0},
+    m_savedJobNumber{0},
     m_event{-1},
     m_run{0},
     m_subRun{0},
@@ -30,6 +37,12 @@ HierarchyAnalysisAlgorithm::HierarchyAnalysisAlgorithm() :
     m_startTime{0},
     m_endTime{0},
     m_triggers{0},
+    m_voxelWidth{0.f},
+    m_overBudget{0},
+    m_nSkippedSlices{0},
+    m_subEvent{-1},
+    m_subEventStartTime{0.f},
+    m_subEventEndTime{0.f},
     m_mcIDs{nullptr},
     m_mcLocalIDs{nullptr},
     m_eventFileName{""},
@@ -71,25 +84,44 @@ HierarchyAnalysisAlgorithm::HierarchyAnalysisAlgorithm() :
 
 HierarchyAnalysisAlgorithm::~HierarchyAnalysisAlgorithm()
 {
-    // Save the analysis output ROOT file. Always recreate this
-    PANDORA_MONITORING_API(SaveTree(this->GetPandora(), m_analysisTreeName.c_str(), m_analysisFileName.c_str(), "RECREATE"));
+    // Save the analysis output ROOT file. Always recreate this, with one file per child process when the events are shared.
+    // The parent of the child processes has no events to save, and a server has already saved the output of each job
+    if ((LArProcessShard::PARENT != LArProcessShard::Get().m_role) && !LArServerJob::Get().IsServer())
+    {
+        const std::string analysisFileName(LArProcessShard::Get().GetFileName(m_analysisFileName));
+        PANDORA_MONITORING_API(SaveTree(this->GetPandora(), m_analysisTreeName.c_str(), analysisFileName.c_str(), "RECREATE"));
+    }
 
-    // Cleanup ROOT file used for the event numbers
-    if (m_eventFile && m_eventFile->IsOpen())
+    this->CloseEventFile();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode HierarchyAnalysisAlgorithm::Reset()
+{
+    // A server saves the analysis output of each job once all of its events have been processed
+    const LArServerJob &serverJob(LArServerJob::Get());
+
+    if (serverJob.IsServer() && serverJob.m_isFinished && (serverJob.m_jobNumber == m_jobNumber) && (m_savedJobNumber != m_jobNumber))
     {
-        delete m_eventTree;
-        m_eventTree = nullptr;
+        PANDORA_MONITORING_API(SaveTree(this->GetPandora(), m_analysisTreeName.c_str(), serverJob.m_outputFileName.c_str(), "RECREATE"));
+        m_savedJobNumber = m_jobNumber;
     }
-    delete m_eventFile;
-    m_eventFile = nullptr;
+
+    return STATUS_CODE_SUCCESS;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 StatusCode HierarchyAnalysisAlgorithm::Run()
 {
-    // Increment the algorithm run count
-    ++m_count;
+    // A server starts again from the first event of each new job
+    if (LArServerJob::Get().IsServer() && (LArServerJob::Get().m_jobNumber != m_jobNumber))
+        this->StartServerJob();
+
+    // Increment the input event count, which stays the same for the sub-events of a spill
+    if (LArSubEvent::Get().m_isNewSpill)
+        ++m_count;
 
     // Need to use 2D calo hit list for now since LArHierarchyHelper::MCHierarchy::IsReconstructable()
     // checks for minimum number of hits in the U, V & W views only, which will fail for 3D
@@ -100,6 +132,18 @@ StatusCode HierarchyAnalysisAlgorithm::Run()
     const PfoList *pPfoList(nullptr);
     PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraContentApi::GetList(*this, m_pfoListName, pPfoList));
 
+    // Voxel width used to make the hits, which is larger than the nominal value for coarsened events
+    m_voxelWidth = pCaloHitList->empty() ? 0.f : pCaloHitList->front()->GetCellSize0();
+
+    // Flag the events whose reconstruction ran out of its time budget, which only have partial results
+    m_overBudget = LArEventBudget::Get().m_isOverBudget ? 1 : 0;
+    m_nSkippedSlices = LArEventBudget::Get().m_nSkippedSlices;
+
+    // Tag the sub-events of a spill with their time window
+    m_subEvent = LArSubEvent::Get().m_subEventIndex;
+    m_subEventStartTime = LArSubEvent::Get().m_startTime;
+    m_subEventEndTime = LArSubEvent::Get().m_endTime;
+
     LArHierarchyHelper::FoldingParameters foldParameters;
     if (m_foldToPrimaries)
         foldParameters.m_foldToTier = true;
@@ -139,10 +183,17 @@ void HierarchyAnalysisAlgorithm::SetEventRunMCIdInfo()
     // MCParticles use unique MC Ids, but CAFs need the local ones as well
     m_mcIdMap.clear();
 
+    // Open the event file for the first event, so that each process has its own file handle
+    if ((0 == m_count) && LArSubEvent::Get().m_isNewSpill)
+        this->OpenEventFile();
+
+    // The input entry, which only differs from the run count if this process has a share of the events
+    const int eventEntry(LArProcessShard::Get().GetEventEntry(m_count));
+
     if (m_eventTree)
     {
         // Sets m_event, m_run, m_subRun, m_unixTime, m_startTime, m_endTime & m_triggers
-        const int iEntry = m_count + m_eventsToSkip;
+        const int iEntry = eventEntry + m_eventsToSkip;
         m_eventTree->GetEntry(iEntry);
 
         // Fill the Id map
@@ -154,7 +205,82 @@ void HierarchyAnalysisAlgorithm::SetEventRunMCIdInfo()
     }
     else
         // Use the algorithm run count number
-        m_event = m_count;
+        m_event = eventEntry;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void HierarchyAnalysisAlgorithm::StartServerJob()
+{
+    const LArServerJob &serverJob(LArServerJob::Get());
+    m_jobNumber = serverJob.m_jobNumber;
+    m_count = -1;
+
+    // The event numbers are read from the input file of the job, if they were read from the input file at all
+    this->CloseEventFile();
+    m_gotMCEventInput = false;
+
+    if (m_eventFileName.size() > 0)
+        m_eventFileName = serverJob.m_inputFileName;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void HierarchyAnalysisAlgorithm::CloseEventFile()
+{
+    // Cleanup ROOT file used for the event numbers
+    if (m_eventFile && m_eventFile->IsOpen())
+    {
+        delete m_eventTree;
+        m_eventTree = nullptr;
+    }
+    delete m_eventFile;
+    m_eventFile = nullptr;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void HierarchyAnalysisAlgorithm::OpenEventFile()
+{
+    // Setup the event ROOT file
+    if (m_eventFileName.size() > 0)
+    {
+        m_eventFile = TFile::Open(m_eventFileName.c_str(), "READ");
+        if (m_eventFile && m_eventFile->IsOpen())
+        {
+            m_eventTree = dynamic_cast<TTree *>(m_eventFile->Get(m_eventTreeName.c_str()));
+            if (m_eventTree)
+            {
+                // Only enable the event and run number leaves as well as the trigger timing.
+                // Also enable the vertex_id leaf
+                m_eventTree->SetBranchStatus("*", 0);
+                m_eventTree->SetBranchStatus(m_eventLeafName.c_str(), 1);
+                m_eventTree->SetBranchStatus(m_runLeafName.c_str(), 1);
+                m_eventTree->SetBranchStatus(m_subRunLeafName.c_str(), 1);
+                m_eventTree->SetBranchStatus(m_unixTimeLeafName.c_str(), 1);
+                m_eventTree->SetBranchStatus(m_startTimeLeafName.c_str(), 1);
+                m_eventTree->SetBranchStatus(m_endTimeLeafName.c_str(), 1);
+                m_eventTree->SetBranchStatus(m_triggersLeafName.c_str(), 1);
+                m_eventTree->SetBranchAddress(m_eventLeafName.c_str(), &m_event);
+                m_eventTree->SetBranchAddress(m_runLeafName.c_str(), &m_run);
+                m_eventTree->SetBranchAddress(m_subRunLeafName.c_str(), &m_subRun);
+                m_eventTree->SetBranchAddress(m_unixTimeLeafName.c_str(), &m_unixTime);
+                m_eventTree->SetBranchAddress(m_startTimeLeafName.c_str(), &m_startTime);
+                m_eventTree->SetBranchAddress(m_endTimeLeafName.c_str(), &m_endTime);
+                m_eventTree->SetBranchAddress(m_triggersLeafName.c_str(), &m_triggers);
+
+                // Check if we have MC branches
+                if (m_eventTree->GetBranch(m_mcIdLeafName.c_str()) && m_eventTree->GetBranch(m_mcLocalIdLeafName.c_str()))
+                {
+                    m_gotMCEventInput = true;
+                    m_eventTree->SetBranchStatus(m_mcIdLeafName.c_str(), 1);
+                    m_eventTree->SetBranchStatus(m_mcLocalIdLeafName.c_str(), 1);
+                    m_eventTree->SetBranchAddress(m_mcIdLeafName.c_str(), &m_mcIDs);
+                    m_eventTree->SetBranchAddress(m_mcLocalIdLeafName.c_str(), &m_mcLocalIDs);
+                }
+            }
+        }
+    }
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -193,6 +319,10 @@ void HierarchyAnalysisAlgorithm::EventAnalysisOutput(const LArHierarchyHelper::M
     // The sliceId & clusterId vectors keep track of where a given hit comes from
     IntVector recoHitIdVect, recoHitSliceIdVect, recoHitClusterIdVect;
     FloatVector recoHitXVect, recoHitYVect, recoHitZVect, recoHitEVect;
+    // The number of original voxels each hit represents (0 if not made from voxels), whose ids follow each other in
+    // recoHitVoxelIdVect in the same hit order, so its size is the sum of recoHitNVoxelsVect
+    IntVector recoHitNVoxelsVect;
+    std::vector<long> recoHitVoxelIdVect, hitVoxelIDs;
 
     // Get the list of root MCParticles for the MC truth matching
     MCParticleList rootMCParticles;
@@ -373,6 +503,10 @@ void HierarchyAnalysisAlgorithm::EventAnalysisOutput(const LArHierarchyHelper::M
                         recoHitYVect.emplace_back(hitPos.GetY());
                         recoHitZVect.emplace_back(hitPos.GetZ());
                         recoHitEVect.emplace_back(hitE);
+
+                        LArEventHitVoxels::Get().GetVoxelIDs(pCalo3DHit->GetParentAddress(), hitVoxelIDs);
+                        recoHitNVoxelsVect.emplace_back(hitVoxelIDs.size());
+                        recoHitVoxelIdVect.insert(recoHitVoxelIdVect.end(), hitVoxelIDs.begin(), hitVoxelIDs.end());
                     }
                 }
 
@@ -440,6 +574,12 @@ void HierarchyAnalysisAlgorithm::EventAnalysisOutput(const LArHierarchyHelper::M
     PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "startTime", m_startTime));
     PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "endTime", m_endTime));
     PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "triggers", m_triggers));
+    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "voxelWidth", m_voxelWidth));
+    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "overBudget", m_overBudget));
+    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "nSkippedSlices", m_nSkippedSlices));
+    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "subEvent", m_subEvent));
+    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "subEventStartTime", m_subEventStartTime));
+    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "subEventEndTime", m_subEventEndTime));
     PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "sliceId", &sliceIdVect));
     PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "nuVtxX", &nuVtxXVect));
     PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "nuVtxY", &nuVtxYVect));
@@ -478,6 +618,8 @@ void HierarchyAnalysisAlgorithm::EventAnalysisOutput(const LArHierarchyHelper::M
         PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "recoHitY", &recoHitYVect));
         PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "recoHitZ", &recoHitZVect));
         PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "recoHitE", &recoHitEVect));
+        PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "recoHitNVoxels", &recoHitNVoxelsVect));
+        PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "recoHitVoxelId", &recoHitVoxelIdVect));
     }
     PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "gotMatch", &matchVect));
     PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "mcPDG", &mcPDGVect));
@@ -617,46 +759,6 @@ StatusCode HierarchyAnalysisAlgorithm::ReadSettings(const TiXmlHandle xmlHandle)
 
     PANDORA_RETURN_RESULT_IF_AND_IF(STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle, "EventsToSkip", m_eventsToSkip));
 
-    // Setup the event ROOT file
-    if (m_eventFileName.size() > 0)
-    {
-        m_eventFile = TFile::Open(m_eventFileName.c_str(), "READ");
-        if (m_eventFile && m_eventFile->IsOpen())
-        {
-            m_eventTree = dynamic_cast<TTree *>(m_eventFile->Get(m_eventTreeName.c_str()));
-            if (m_eventTree)
-            {
-                // Only enable the event and run number leaves as well as the trigger timing.
-                // Also enable the vertex_id leaf
-                m_eventTree->SetBranchStatus("*", 0);
-                m_eventTree->SetBranchStatus(m_eventLeafName.c_str(), 1);
-                m_eventTree->SetBranchStatus(m_runLeafName.c_str(), 1);
-                m_eventTree->SetBranchStatus(m_subRunLeafName.c_str(), 1);
-                m_eventTree->SetBranchStatus(m_unixTimeLeafName.c_str(), 1);
-                m_eventTree->SetBranchStatus(m_startTimeLeafName.c_str(), 1);
-                m_eventTree->SetBranchStatus(m_endTimeLeafName.c_str(), 1);
-                m_eventTree->SetBranchStatus(m_triggersLeafName.c_str(), 1);
-                m_eventTree->SetBranchAddress(m_eventLeafName.c_str(), &m_event);
-                m_eventTree->SetBranchAddress(m_runLeafName.c_str(), &m_run);
-                m_eventTree->SetBranchAddress(m_subRunLeafName.c_str(), &m_subRun);
-                m_eventTree->SetBranchAddress(m_unixTimeLeafName.c_str(), &m_unixTime);
-                m_eventTree->SetBranchAddress(m_startTimeLeafName.c_str(), &m_startTime);
-                m_eventTree->SetBranchAddress(m_endTimeLeafName.c_str(), &m_endTime);
-                m_eventTree->SetBranchAddress(m_triggersLeafName.c_str(), &m_triggers);
-
-                // Check if we have MC branches
-                if (m_eventTree->GetBranch(m_mcIdLeafName.c_str()) && m_eventTree->GetBranch(m_mcLocalIdLeafName.c_str()))
-                {
-                    m_gotMCEventInput = true;
-                    m_eventTree->SetBranchStatus(m_mcIdLeafName.c_str(), 1);
-                    m_eventTree->SetBranchStatus(m_mcLocalIdLeafName.c_str(), 1);
-                    m_eventTree->SetBranchAddress(m_mcIdLeafName.c_str(), &m_mcIDs);
-                    m_eventTree->SetBranchAddress(m_mcLocalIdLeafName.c_str(), &m_mcLocalIDs);
-                }
-            }
-        }
-    }
-
     PANDORA_RETURN_RESULT_IF_AND_IF(STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle, "CaloHitListName", m_caloHitListName));
     PANDORA_RETURN_RESULT_IF_AND_IF(STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle, "PfoListName", m_pfoListName));
 
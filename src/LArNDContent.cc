@@ -22,6 +22,7 @@
 #include "MergeClearTracksThreeDAlgorithm.h"
 #include "PfoThreeDHitAssignmentAlgorithm.h"
 #include "PreProcessingThreeDAlgorithm.h"
+#include "ProfilingAlgorithm.h"
 #include "ReplaceHitAndClusterListsAlgorithm.h"
 #include "SimpleClusterCreationThreeDAlgorithm.h"
 #include "SlicingThreeDAlgorithm.h"
@@ -38,7 +39,8 @@
     d("LArPreProcessingThreeD",                 PreProcessingThreeDAlgorithm)                                                      \
     d("LArCutClusterCharacterisationThreeD",    CutClusterCharacterisationThreeDAlgorithm)                                         \
     d("LArCandidateVertexCreationThreeD",       CandidateVertexCreationThreeDAlgorithm)                                            \
-    d("LArHierarchyAnalysis",                   HierarchyAnalysisAlgorithm)
+    d("LArHierarchyAnalysis",                   HierarchyAnalysisAlgorithm)                                                        \
+    d("LArProfiling",                           ProfilingAlgorithm)
 
 #define LAR_ND_ALGORITHM_TOOL_LIST(d)                                                                                              \
     d("LArEventSlicingThreeD",                  EventSlicingThreeDTool)                                                            \
@@ -10,7 +10,13 @@
 
 #include "Pandora/AlgorithmHeaders.h"
 
+#include "LArEventBudget.h"
+#include "LArEventHitVolumes.h"
 #include "LArNDContent.h"
+#include "LArProcessShard.h"
+#include "LArProfile.h"
+#include "LArServerJob.h"
+#include "LArSubEvent.h"
 #include "MasterThreeDAlgorithm.h"
 
 #include "larpandoracontent/LArContent.h"
@@ -32,28 +38,100 @@
 #include "larpandoradlcontent/LArDLContent.h"
 #endif
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <system_error>
+#include <thread>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
 using namespace pandora;
 
 namespace lar_content
 {
 
+MasterThreeDAlgorithm::MasterThreeDAlgorithm() :
+    m_crWorkerIdleEventLimit(0),
+    m_nCRWorkerThreads(1),
+    m_nSliceWorkers(1),
+    m_eventTimeBudget(0.f),
+    m_budgetMaxSliceHits(0),
+    m_eventCount(-1)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+MasterThreeDAlgorithm::~MasterThreeDAlgorithm()
+{
+    // The cosmic-ray worker instances are owned here, rather than by the multi pandora api
+    for (const VolumeIdToPandoraMap::value_type &mapEntry : m_crWorkerInstanceMap)
+        delete mapEntry.second;
+
+    // Leave no dangling addresses for the base class to use
+    m_crWorkerInstances.clear();
+    m_crWorkerInstanceMap.clear();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 StatusCode MasterThreeDAlgorithm::Run()
 {
     std::cout << "Should run slicing? " << m_shouldRunSlicing << std::endl;
 
+    // The slice file records are keyed on the input event entry, which restarts with each job of a server
+    if ((!m_sliceOutputFileName.empty() || !m_sliceInputFileName.empty()) && LArServerJob::Get().IsServer())
+    {
+        std::cout << "MasterThreeDAlgorithm: slice files cannot be used in server mode" << std::endl;
+        return STATUS_CODE_NOT_ALLOWED;
+    }
+
+    // Nor can they hold more than one event for each input event entry
+    if ((!m_sliceOutputFileName.empty() || !m_sliceInputFileName.empty()) && (LArSubEvent::Get().m_subEventIndex >= 0))
+    {
+        std::cout << "MasterThreeDAlgorithm: slice files cannot be used for the sub-events of a spill" << std::endl;
+        return STATUS_CODE_NOT_ALLOWED;
+    }
+
+    // The slice records do not hold the clear cosmic-ray pfos of the all-hits cosmic-ray reconstruction, which would be lost
+    if (!m_sliceInputFileName.empty() && m_shouldRunAllHitsCosmicReco)
+    {
+        std::cout << "MasterThreeDAlgorithm: slice files cannot be read while running the all-hits cosmic-ray reconstruction" << std::endl;
+        return STATUS_CODE_NOT_ALLOWED;
+    }
+
+    ++m_eventCount;
+
     PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->Reset());
 
     if (!m_workerInstancesInitialized)
         PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->InitializeWorkerInstances());
 
-    if (m_passMCParticlesToWorkerInstances)
-        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->CopyMCParticles());
-
-    PfoToFloatMap stitchedPfosToX0Map;
+    // The cosmic-ray workers are not needed when reading the slices from file
+    const bool readSlices(!m_sliceInputFileName.empty());
     VolumeIdToHitListMap volumeIdToHitListMap;
     PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->GetVolumeIdToHitListMap(volumeIdToHitListMap));
 
-    if (m_shouldRunAllHitsCosmicReco)
+    if (!readSlices)
+        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->UpdateCosmicRayWorkerInstances(volumeIdToHitListMap));
+
+    // The time budget excludes the one-off creation of the worker instances, including the cosmic-ray workers for new volumes
+    m_eventStartTime = std::chrono::steady_clock::now();
+    LArEventBudget::Get().Clear();
+
+    PfoToFloatMap stitchedPfosToX0Map;
+
+    // The hit removal, which relies on the pfos of the all-hits cosmic-ray reconstruction, is skipped when reading the slices from
+    // file, as the slices already reflect the hit removal; both are skipped once over budget
+    const bool skipCosmicReco(readSlices || (m_shouldRunAllHitsCosmicReco && this->IsOverBudget("cosmic-ray reconstruction")));
+
+    if (m_shouldRunAllHitsCosmicReco && !skipCosmicReco)
     {
         PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->RunCosmicRayReconstruction(volumeIdToHitListMap));
 
@@ -64,7 +142,7 @@ StatusCode MasterThreeDAlgorithm::Run()
             PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->StitchCosmicRayPfos(pfoToLArTPCMap, stitchedPfosToX0Map));
     }
 
-    if (m_shouldRunCosmicHitRemoval)
+    if (m_shouldRunCosmicHitRemoval && !skipCosmicReco)
     {
         PfoList clearCosmicRayPfos, ambiguousPfos;
         PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->TagCosmicRayPfos(stitchedPfosToX0Map, clearCosmicRayPfos, ambiguousPfos));
@@ -72,7 +150,18 @@ StatusCode MasterThreeDAlgorithm::Run()
     }
 
     SliceVector sliceVector;
-    PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->RunSlicing(volumeIdToHitListMap, sliceVector));
+
+    if (readSlices)
+    {
+        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->ReadSlices(sliceVector));
+    }
+    else
+    {
+        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->RunSlicing(volumeIdToHitListMap, sliceVector));
+
+        if (!m_sliceOutputFileName.empty())
+            PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->WriteSlices(sliceVector));
+    }
 
     if (m_shouldRunNeutrinoRecoOption || m_shouldRunCosmicRecoOption)
     {
@@ -86,37 +175,56 @@ StatusCode MasterThreeDAlgorithm::Run()
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+StatusCode MasterThreeDAlgorithm::Reset()
+{
+    PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, MasterAlgorithm::Reset());
+    m_workerMCParticles.clear();
+
+    // The first worker instance of each pool is reset by the master algorithm
+    for (const PandoraInstanceList *const pWorkerPool : {&m_sliceNuWorkerPool, &m_sliceCRWorkerPool})
+    {
+        for (size_t iWorker = 1; iWorker < pWorkerPool->size(); ++iWorker)
+        {
+            if (pWorkerPool->at(iWorker))
+                PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::Reset(*pWorkerPool->at(iWorker)));
+        }
+    }
+
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 StatusCode MasterThreeDAlgorithm::RunSlicing(const VolumeIdToHitListMap &volumeIdToHitListMap, SliceVector &sliceVector) const
 {
     std::cout << "There are " << volumeIdToHitListMap.size() << " volumes" << std::endl;
+    CaloHitList availableHits;
+
     for (const VolumeIdToHitListMap::value_type &mapEntry : volumeIdToHitListMap)
     {
         std::cout << "- Volume has " << mapEntry.second.m_allHitList.size() << " hits" << std::endl;
         for (const CaloHit *const pCaloHit : (m_shouldRemoveOutOfTimeHits ? mapEntry.second.m_truncatedHitList : mapEntry.second.m_allHitList))
         {
-            if (!PandoraContentApi::IsAvailable(*this, pCaloHit))
-                continue;
-
-            if (m_shouldRunSlicing)
-            {
-                PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->Copy(m_pSlicingWorkerInstance, pCaloHit));
-            }
-            else
-            {
-                if (sliceVector.empty())
-                    sliceVector.push_back(CaloHitList());
-                sliceVector.back().push_back(pCaloHit);
-            }
+            if (PandoraContentApi::IsAvailable(*this, pCaloHit))
+                availableHits.push_back(pCaloHit);
         }
     }
 
-    if (m_shouldRunSlicing)
+    if (!m_shouldRunSlicing)
+    {
+        if (!availableHits.empty())
+            sliceVector.push_back(std::move(availableHits));
+    }
+    else
     {
+        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->CopyCaloHits(m_pSlicingWorkerInstance, availableHits));
+        LArProfile::Get().SetInstanceEvent(m_pSlicingWorkerInstance, -1, availableHits.size());
+
         if (m_printOverallRecoStatus)
             std::cout << "Running slicing worker instance" << std::endl;
 
         const PfoList *pSlicePfos(nullptr);
-        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::ProcessEvent(*m_pSlicingWorkerInstance));
+        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, MasterThreeDAlgorithm::ProcessWorkerInstance(m_pSlicingWorkerInstance));
         PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::GetCurrentPfoList(*m_pSlicingWorkerInstance, pSlicePfos));
 
         if (m_visualizeOverallRecoStatus)
@@ -143,11 +251,460 @@ StatusCode MasterThreeDAlgorithm::RunSlicing(const VolumeIdToHitListMap &volumeI
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+StatusCode MasterThreeDAlgorithm::WriteSlices(const SliceVector &sliceVector)
+{
+    const std::string fileName(LArProcessShard::Get().GetFileName(m_sliceOutputFileName));
+
+    if (!m_sliceFile.IsOpen() && !m_sliceFile.OpenForWriting(fileName))
+    {
+        std::cout << "MasterThreeDAlgorithm: unable to open slice file " << fileName << std::endl;
+        return STATUS_CODE_FAILURE;
+    }
+
+    const CaloHitList *pCaloHitList(nullptr);
+    PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraContentApi::GetList(*this, m_inputHitListName, pCaloHitList));
+
+    LArSliceHitIdVector sliceHitIds;
+
+    for (const CaloHitList &sliceHits : sliceVector)
+    {
+        sliceHitIds.emplace_back();
+        sliceHitIds.back().reserve(sliceHits.size());
+
+        for (const CaloHit *const pSliceCaloHit : sliceHits)
+        {
+            // The slicing worker hits point back to the master instance hits
+            const CaloHit *const pCaloHit(
+                m_shouldRunSlicing ? static_cast<const CaloHit *>(pSliceCaloHit->GetParentAddress()) : pSliceCaloHit);
+            const std::uintptr_t hitId(reinterpret_cast<std::uintptr_t>(pCaloHit->GetParentAddress()));
+
+            if (hitId > std::numeric_limits<std::uint32_t>::max())
+            {
+                std::cout << "MasterThreeDAlgorithm: slice files need the application to set hit counters as the hit parent addresses"
+                          << std::endl;
+                return STATUS_CODE_NOT_ALLOWED;
+            }
+
+            sliceHitIds.back().push_back(hitId);
+        }
+    }
+
+    if (!m_sliceFile.WriteEvent(LArProcessShard::Get().GetEventEntry(m_eventCount), pCaloHitList->size(), sliceHitIds))
+    {
+        std::cout << "MasterThreeDAlgorithm: unable to write to slice file " << fileName << std::endl;
+        return STATUS_CODE_FAILURE;
+    }
+
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode MasterThreeDAlgorithm::ReadSlices(SliceVector &sliceVector)
+{
+    if (!m_sliceFile.IsOpen() && !m_sliceFile.OpenForReading(m_sliceInputFileName))
+    {
+        std::cout << "MasterThreeDAlgorithm: unable to read slice file " << m_sliceInputFileName << std::endl;
+        return STATUS_CODE_NOT_FOUND;
+    }
+
+    const CaloHitList *pCaloHitList(nullptr);
+    PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraContentApi::GetList(*this, m_inputHitListName, pCaloHitList));
+
+    const int eventEntry(LArProcessShard::Get().GetEventEntry(m_eventCount));
+    std::uint32_t nInputHits(0);
+    LArSliceHitIdVector sliceHitIds;
+
+    if (!m_sliceFile.ReadEvent(eventEntry, nInputHits, sliceHitIds) || (nInputHits != pCaloHitList->size()))
+    {
+        std::cout << "MasterThreeDAlgorithm: slice file " << m_sliceInputFileName << " has no slices for event entry " << eventEntry
+                  << " with " << pCaloHitList->size() << " hits" << std::endl;
+        return STATUS_CODE_NOT_FOUND;
+    }
+
+    std::unordered_map<std::uintptr_t, const CaloHit *> hitIdToCaloHitMap;
+    hitIdToCaloHitMap.reserve(pCaloHitList->size());
+
+    for (const CaloHit *const pCaloHit : *pCaloHitList)
+        hitIdToCaloHitMap[reinterpret_cast<std::uintptr_t>(pCaloHit->GetParentAddress())] = pCaloHit;
+
+    for (const std::vector<std::uint32_t> &hitIds : sliceHitIds)
+    {
+        sliceVector.push_back(CaloHitList());
+
+        for (const std::uint32_t hitId : hitIds)
+        {
+            const std::unordered_map<std::uintptr_t, const CaloHit *>::const_iterator iter(hitIdToCaloHitMap.find(hitId));
+
+            if (hitIdToCaloHitMap.end() == iter)
+            {
+                std::cout << "MasterThreeDAlgorithm: slice file " << m_sliceInputFileName << " has unknown hit id " << hitId << std::endl;
+                return STATUS_CODE_NOT_FOUND;
+            }
+
+            sliceVector.back().push_back(iter->second);
+        }
+    }
+
+    if (m_printOverallRecoStatus)
+        std::cout << "Read " << sliceVector.size() << " slice(s) from file" << std::endl;
+
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode MasterThreeDAlgorithm::RunCosmicRayReconstruction(const VolumeIdToHitListMap &volumeIdToHitListMap) const
+{
+    // Copy the hits on this thread, in the same order as a serial reconstruction
+    std::vector<std::pair<size_t, const Pandora *>> nHitsAndWorkers;
+    unsigned int workerCounter(0);
+
+    for (const Pandora *const pCRWorker : m_crWorkerInstances)
+    {
+        const LArTPC &larTPC(pCRWorker->GetGeometry()->GetLArTPC());
+        VolumeIdToHitListMap::const_iterator iter(volumeIdToHitListMap.find(larTPC.GetLArTPCVolumeId()));
+
+        if (volumeIdToHitListMap.end() == iter)
+            continue;
+
+        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->CopyCaloHits(pCRWorker, iter->second.m_allHitList));
+        LArProfile::Get().SetInstanceEvent(pCRWorker, -1, iter->second.m_allHitList.size());
+
+        if (m_printOverallRecoStatus)
+            std::cout << "Running cosmic-ray reconstruction worker instance " << ++workerCounter << " of " << m_crWorkerInstances.size()
+                      << std::endl;
+
+        nHitsAndWorkers.emplace_back(iter->second.m_allHitList.size(), pCRWorker);
+    }
+
+    // Start the busiest workers first, so that the event takes about as long as its busiest LArTPC. The pfos are harvested
+    // afterwards, in volume id order
+    std::stable_sort(nHitsAndWorkers.begin(), nHitsAndWorkers.end(),
+        [](const std::pair<size_t, const Pandora *> &lhs, const std::pair<size_t, const Pandora *> &rhs) { return lhs.first > rhs.first; });
+
+    PandoraInstanceList activeWorkers;
+    for (const std::pair<size_t, const Pandora *> &nHitsAndWorker : nHitsAndWorkers)
+        activeWorkers.push_back(nHitsAndWorker.second);
+
+    return MasterThreeDAlgorithm::ProcessWorkerInstances(activeWorkers, m_nCRWorkerThreads);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode MasterThreeDAlgorithm::RunSliceReconstruction(
+    SliceVector &sliceVector, SliceHypotheses &nuSliceHypotheses, SliceHypotheses &crSliceHypotheses) const
+{
+    SliceVector selectedSliceVector;
+    if (m_shouldRunSlicing && !m_sliceSelectionToolVector.empty())
+    {
+        SliceVector inputSliceVector(sliceVector);
+        for (SliceSelectionBaseTool *const pSliceSelectionTool : m_sliceSelectionToolVector)
+        {
+            pSliceSelectionTool->SelectSlices(this, inputSliceVector, selectedSliceVector);
+            inputSliceVector = selectedSliceVector;
+        }
+    }
+    else
+    {
+        selectedSliceVector = std::move(sliceVector);
+    }
+
+    // Each round gives one slice to each worker instance of the pool. Only a single worker sees every slice in turn, as the serial
+    // reconstruction does, so the shipped settings keep one worker of each kind
+    const size_t nSlices(selectedSliceVector.size());
+    const size_t nPoolWorkers(std::min(m_sliceNuWorkerPool.size(), m_sliceCRWorkerPool.size()));
+
+    if (0 == nPoolWorkers)
+        return STATUS_CODE_NOT_INITIALIZED;
+
+    size_t iSlice(0);
+
+    while (iSlice < nSlices)
+    {
+        // Once over budget, the slices with too many hits are skipped and the remaining slices fill the round
+        const bool isOverBudget(this->IsOverBudget("slice reconstruction"));
+        std::vector<size_t> roundSlices;
+        PandoraInstanceList roundWorkers;
+
+        for (; (iSlice < nSlices) && (roundSlices.size() < nPoolWorkers); ++iSlice)
+        {
+            const CaloHitList &sliceHits(selectedSliceVector.at(iSlice));
+
+            if (isOverBudget && (sliceHits.size() > m_budgetMaxSliceHits))
+            {
+                ++LArEventBudget::Get().m_nSkippedSlices;
+                continue;
+            }
+
+            const size_t iWorker(roundSlices.size());
+            const Pandora *const pNuWorker(m_sliceNuWorkerPool.at(iWorker));
+            const Pandora *const pCRWorker(m_sliceCRWorkerPool.at(iWorker));
+            roundSlices.push_back(iSlice);
+
+            // ATTN Must ensure we copy the hits actually owned by master instance; access differs with/without slicing enabled
+            CaloHitList masterSliceHits;
+
+            if (m_shouldRunSlicing && m_sliceInputFileName.empty())
+            {
+                for (const CaloHit *const pSliceCaloHit : sliceHits)
+                    masterSliceHits.push_back(static_cast<const CaloHit *>(pSliceCaloHit->GetParentAddress()));
+            }
+
+            const CaloHitList &caloHitsInMaster((m_shouldRunSlicing && m_sliceInputFileName.empty()) ? masterSliceHits : sliceHits);
+
+            if (m_shouldRunNeutrinoRecoOption)
+                PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->CopyCaloHits(pNuWorker, caloHitsInMaster));
+
+            if (m_shouldRunCosmicRecoOption)
+                PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->CopyCaloHits(pCRWorker, caloHitsInMaster));
+
+            LArProfile::Get().SetInstanceEvent(pNuWorker, iSlice, caloHitsInMaster.size());
+            LArProfile::Get().SetInstanceEvent(pCRWorker, iSlice, caloHitsInMaster.size());
+
+            if (m_printOverallRecoStatus)
+                std::cout << "Running slice worker instances " << iWorker << " for slice " << (iSlice + 1) << " of " << nSlices
+                          << std::endl;
+
+            if (m_shouldRunNeutrinoRecoOption)
+                roundWorkers.push_back(pNuWorker);
+
+            if (m_shouldRunCosmicRecoOption)
+                roundWorkers.push_back(pCRWorker);
+        }
+
+        const unsigned int nRoundThreads(m_nSliceWorkers > 1 ? roundWorkers.size() : 1);
+        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, MasterThreeDAlgorithm::ProcessWorkerInstances(roundWorkers, nRoundThreads));
+
+        // Collect the hypotheses in slice order
+        for (size_t iWorker = 0; iWorker < roundSlices.size(); ++iWorker)
+        {
+            if (m_shouldRunNeutrinoRecoOption)
+            {
+                const PfoList *pSliceNuPfos(nullptr);
+                PANDORA_RETURN_RESULT_IF(
+                    STATUS_CODE_SUCCESS, !=, PandoraApi::GetCurrentPfoList(*m_sliceNuWorkerPool.at(iWorker), pSliceNuPfos));
+                nuSliceHypotheses.push_back(*pSliceNuPfos);
+            }
+
+            if (m_shouldRunCosmicRecoOption)
+            {
+                const PfoList *pSliceCRPfos(nullptr);
+                PANDORA_RETURN_RESULT_IF(
+                    STATUS_CODE_SUCCESS, !=, PandoraApi::GetCurrentPfoList(*m_sliceCRWorkerPool.at(iWorker), pSliceCRPfos));
+                crSliceHypotheses.push_back(*pSliceCRPfos);
+            }
+        }
+    }
+
+    if (LArEventBudget::Get().m_nSkippedSlices > 0)
+        std::cout << "MasterThreeDAlgorithm: skipped " << LArEventBudget::Get().m_nSkippedSlices << " of " << nSlices
+                  << " slices over the time budget" << std::endl;
+
+    if (m_shouldRunNeutrinoRecoOption && m_shouldRunCosmicRecoOption && (nuSliceHypotheses.size() != crSliceHypotheses.size()))
+        return STATUS_CODE_FAILURE;
+
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool MasterThreeDAlgorithm::IsOverBudget(const std::string &stageName) const
+{
+    if (m_eventTimeBudget <= 0.f)
+        return false;
+
+    LArEventBudget &eventBudget(LArEventBudget::Get());
+
+    if (eventBudget.m_isOverBudget)
+        return true;
+
+    const std::chrono::duration<float> elapsedTime(std::chrono::steady_clock::now() - m_eventStartTime);
+
+    if (elapsedTime.count() <= m_eventTimeBudget)
+        return false;
+
+    eventBudget.m_isOverBudget = true;
+    std::cout << "MasterThreeDAlgorithm: event time budget of " << m_eventTimeBudget << " s exceeded after " << elapsedTime.count()
+              << " s, degrading " << stageName << std::endl;
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode MasterThreeDAlgorithm::CopyCaloHits(const Pandora *const pPandora, const CaloHitList &caloHitList) const
+{
+    // One set of parameters for the whole list, each field of which is overwritten for every hit
+    LArCaloHitParameters parameters;
+    std::unordered_set<const MCParticle *> mcParticleSet;
+    MCParticleVector mcParticleVector;
+
+    for (const CaloHit *const pCaloHit : caloHitList)
+    {
+        const LArCaloHit *const pLArCaloHit(dynamic_cast<const LArCaloHit *>(pCaloHit));
+
+        if (!pLArCaloHit)
+        {
+            std::cout << "MasterThreeDAlgorithm::CopyCaloHits - Expected LArCaloHit." << std::endl;
+            return STATUS_CODE_FAILURE;
+        }
+
+        pLArCaloHit->FillParameters(parameters);
+        parameters.m_pParentAddress = static_cast<const void *>(pLArCaloHit);
+        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::CaloHit::Create(*pPandora, parameters, m_hitFactory));
+
+        if (!m_passMCParticlesToWorkerInstances)
+            continue;
+
+        // Set the relationships in a reproducible order, as the weight map is keyed on addresses
+        const MCParticleWeightMap &mcParticleWeightMap(pLArCaloHit->GetMCParticleWeightMap());
+        mcParticleVector.clear();
+
+        for (const MCParticleWeightMap::value_type &mapEntry : mcParticleWeightMap)
+            mcParticleVector.push_back(mapEntry.first);
+
+        std::sort(mcParticleVector.begin(), mcParticleVector.end(), LArMCParticleHelper::SortByMomentum);
+
+        for (const MCParticle *const pMCParticle : mcParticleVector)
+        {
+            PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=,
+                PandoraApi::SetCaloHitToMCParticleRelationship(*pPandora, pLArCaloHit, pMCParticle, mcParticleWeightMap.at(pMCParticle)));
+            mcParticleSet.insert(pMCParticle);
+        }
+    }
+
+    if (m_passMCParticlesToWorkerInstances)
+        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->CopyMCParticles(pPandora, mcParticleSet));
+
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode MasterThreeDAlgorithm::CopyMCParticles(
+    const Pandora *const pPandora, const std::unordered_set<const MCParticle *> &mcParticleSet) const
+{
+    // Gather the contributing mc particles and their ancestors, stopping at those already copied to this worker instance
+    std::unordered_set<const MCParticle *> &copiedMCParticles(m_workerMCParticles[pPandora]);
+    MCParticleVector mcParticlesToCopy, mcParticleStack(mcParticleSet.begin(), mcParticleSet.end());
+
+    while (!mcParticleStack.empty())
+    {
+        const MCParticle *const pMCParticle(mcParticleStack.back());
+        mcParticleStack.pop_back();
+
+        if (!copiedMCParticles.insert(pMCParticle).second)
+            continue;
+
+        mcParticlesToCopy.push_back(pMCParticle);
+
+        for (const MCParticle *const pParentMCParticle : pMCParticle->GetParentList())
+            mcParticleStack.push_back(pParentMCParticle);
+    }
+
+    // The relationships to mc particles that are not copied, such as the daughters of an ancestor, are ignored by the worker
+    std::sort(mcParticlesToCopy.begin(), mcParticlesToCopy.end(), LArMCParticleHelper::SortByMomentum);
+
+    for (const MCParticle *const pMCParticle : mcParticlesToCopy)
+        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->Copy(pPandora, pMCParticle, &m_mcFactory));
+
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode MasterThreeDAlgorithm::ProcessWorkerInstance(const Pandora *const pWorkerInstance)
+{
+    LArProfile &profile(LArProfile::Get());
+
+    if (!profile.IsEnabled())
+        return PandoraApi::ProcessEvent(*pWorkerInstance);
+
+    const double startWallTime(LArProfile::GetWallTime()), startCPUTime(LArProfile::GetCPUTime());
+    const StatusCode statusCode(PandoraApi::ProcessEvent(*pWorkerInstance));
+    profile.AddEntry(
+        pWorkerInstance, "ProcessEvent", -1, LArProfile::GetWallTime() - startWallTime, LArProfile::GetCPUTime() - startCPUTime);
+
+    return statusCode;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode MasterThreeDAlgorithm::ProcessWorkerInstances(const PandoraInstanceList &workerInstances, const unsigned int nThreads)
+{
+    std::vector<StatusCode> statusCodes(workerInstances.size(), STATUS_CODE_SUCCESS);
+    std::atomic<size_t> nextWorker(0);
+
+    const auto processWorkers = [&workerInstances, &statusCodes, &nextWorker]()
+    {
+        for (size_t iWorker = nextWorker++; iWorker < workerInstances.size(); iWorker = nextWorker++)
+        {
+            try
+            {
+                statusCodes[iWorker] = MasterThreeDAlgorithm::ProcessWorkerInstance(workerInstances[iWorker]);
+            }
+            catch (...)
+            {
+                statusCodes[iWorker] = STATUS_CODE_FAILURE;
+            }
+        }
+    };
+
+    // Forked processes share the available CPUs, rather than each asking for all of them
+    const unsigned int nProcesses(static_cast<unsigned int>(std::max(1, LArProcessShard::Get().m_nProcesses)));
+    const unsigned int nRequestedThreads(nThreads > 0 ? nThreads : std::max(1u, MasterThreeDAlgorithm::GetNAvailableCPUs() / nProcesses));
+    const size_t nUsedThreads(std::min<size_t>(nRequestedThreads, workerInstances.size()));
+    std::vector<std::thread> threads;
+
+    for (size_t iThread = 1; iThread < nUsedThreads; ++iThread)
+    {
+        try
+        {
+            threads.emplace_back(processWorkers);
+        }
+        catch (const std::system_error &)
+        {
+            // Carry on with the threads that could be started
+            break;
+        }
+    }
+
+    processWorkers();
+
+    for (std::thread &thread : threads)
+        thread.join();
+
+    for (const StatusCode statusCode : statusCodes)
+        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, statusCode);
+
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+unsigned int MasterThreeDAlgorithm::GetNAvailableCPUs()
+{
+#ifdef __linux__
+    // The affinity mask holds the CPUs that the batch system allows this process to use
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+
+    if (0 == sched_getaffinity(0, sizeof(cpuSet), &cpuSet))
+        return std::max(1, CPU_COUNT(&cpuSet));
+#endif
+
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 const Pandora *MasterThreeDAlgorithm::CreateWorkerInstance(
     const LArTPC &larTPC, const DetectorGapList &gapList, const std::string &settingsFile, const std::string &name) const
 {
     // The Pandora instance
     const Pandora *const pPandora(new Pandora(name));
+    LArProfile::Get().SetInstanceName(pPandora, name);
     PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, LArContent::RegisterAlgorithms(*pPandora));
     PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, LArContent::RegisterBasicPlugins(*pPandora));
     PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, LArNDContent::RegisterAlgorithms(*pPandora));
@@ -155,7 +712,6 @@ const Pandora *MasterThreeDAlgorithm::CreateWorkerInstance(
     PANDORA_THROW_RESULT_IF(
         STATUS_CODE_SUCCESS, !=, PandoraApi::SetLArTransformationPlugin(*pPandora, new lar_content::LArRotationalTransformationPlugin));
     PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->RegisterCustomContent(pPandora));
-    MultiPandoraApi::AddDaughterPandoraInstance(&(this->GetPandora()), pPandora);
 
     // The LArTPC
     PandoraApi::Geometry::LArTPC::Parameters larTPCParameters;
@@ -206,7 +762,7 @@ const Pandora *MasterThreeDAlgorithm::CreateWorkerInstance(
     }
 
     // Configuration
-    PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::ReadSettings(*pPandora, settingsFile));
+    this->ReadWorkerSettings(pPandora, settingsFile);
     return pPandora;
 }
 
@@ -223,6 +779,7 @@ const Pandora *MasterThreeDAlgorithm::CreateWorkerInstance(
 
     // The Pandora instance
     const Pandora *const pPandora(new Pandora(name));
+    LArProfile::Get().SetInstanceName(pPandora, name);
     PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, LArContent::RegisterAlgorithms(*pPandora));
     PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, LArContent::RegisterBasicPlugins(*pPandora));
     PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, LArNDContent::RegisterAlgorithms(*pPandora));
@@ -292,15 +849,59 @@ const Pandora *MasterThreeDAlgorithm::CreateWorkerInstance(
     }
 
     // Configuration
-    PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::ReadSettings(*pPandora, settingsFile));
+    this->ReadWorkerSettings(pPandora, settingsFile);
     return pPandora;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+void MasterThreeDAlgorithm::ReadWorkerSettings(const Pandora *const pPandora, const std::string &settingsFile) const
+{
+    const TiXmlDocument &xmlDocument(MasterThreeDAlgorithm::GetSettingsDocument(settingsFile, m_printOverallRecoStatus));
+
+    const auto startTime(std::chrono::steady_clock::now());
+    PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::ReadSettings(*pPandora, xmlDocument.FirstChildElement()));
+    const std::chrono::duration<double, std::milli> duration(std::chrono::steady_clock::now() - startTime);
+
+    if (m_printOverallRecoStatus)
+    {
+        std::cout << "MasterThreeDAlgorithm: configured " << pPandora->GetName() << " from " << settingsFile << " in "
+                  << duration.count() << " ms" << std::endl;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+const TiXmlDocument &MasterThreeDAlgorithm::GetSettingsDocument(const std::string &settingsFile, const bool shouldPrintTime)
+{
+    // Shared by all master algorithm instances, so each settings file is parsed once per process
+    static std::map<std::string, std::unique_ptr<TiXmlDocument>> settingsDocumentMap;
+
+    const auto iter(settingsDocumentMap.find(settingsFile));
+    if (settingsDocumentMap.end() != iter)
+        return *(iter->second);
+
+    const auto startTime(std::chrono::steady_clock::now());
+    std::unique_ptr<TiXmlDocument> pXmlDocument(std::make_unique<TiXmlDocument>(settingsFile));
+
+    if (!pXmlDocument->LoadFile() || !pXmlDocument->FirstChildElement())
+    {
+        std::cout << "MasterThreeDAlgorithm: invalid xml settings file " << settingsFile << std::endl;
+        throw StatusCodeException(STATUS_CODE_FAILURE);
+    }
+
+    const std::chrono::duration<double, std::milli> duration(std::chrono::steady_clock::now() - startTime);
+    if (shouldPrintTime)
+        std::cout << "MasterThreeDAlgorithm: parsed " << settingsFile << " in " << duration.count() << " ms" << std::endl;
+
+    return *(settingsDocumentMap.emplace(settingsFile, std::move(pXmlDocument)).first->second);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 StatusCode MasterThreeDAlgorithm::InitializeWorkerInstances()
 {
-    // ATTN Used to be in the regular Initialize callback, but detector gap list cannot be extracted in client app before the first event
+    // ATTN Called on the first event, unless the geometry, including the detector gap list, was already available when reading settings
     if (m_workerInstancesInitialized)
         return STATUS_CODE_ALREADY_INITIALIZED;
 
@@ -309,14 +910,8 @@ StatusCode MasterThreeDAlgorithm::InitializeWorkerInstances()
         const LArTPCMap &larTPCMap(this->GetPandora().GetGeometry()->GetLArTPCMap());
         const DetectorGapList &gapList(this->GetPandora().GetGeometry()->GetDetectorGapList());
 
-        for (const LArTPCMap::value_type &mapEntry : larTPCMap)
-        {
-            const unsigned int volumeId(mapEntry.second->GetLArTPCVolumeId());
-            m_crWorkerInstances.push_back(
-                this->CreateWorkerInstance(*(mapEntry.second), gapList, m_crSettingsFile, "CRWorkerInstance" + std::to_string(volumeId)));
-        }
-
-        if (m_shouldRunSlicing)
+        // No slicing worker instance is needed if the slices are read from file
+        if (m_shouldRunSlicing && m_sliceInputFileName.empty())
             m_pSlicingWorkerInstance = this->CreateWorkerInstance(larTPCMap, gapList, m_slicingSettingsFile, "SlicingWorker");
 
         if (m_shouldRunNeutrinoRecoOption)
@@ -324,6 +919,21 @@ StatusCode MasterThreeDAlgorithm::InitializeWorkerInstances()
 
         if (m_shouldRunCosmicRecoOption)
             m_pSliceCRWorkerInstance = this->CreateWorkerInstance(larTPCMap, gapList, m_crSettingsFile, "SliceCRWorker");
+
+        // The rest of the pool of identically configured slice worker instances
+        m_sliceNuWorkerPool.assign(1, m_pSliceNuWorkerInstance);
+        m_sliceCRWorkerPool.assign(1, m_pSliceCRWorkerInstance);
+
+        for (unsigned int iWorker = 1; iWorker < m_nSliceWorkers; ++iWorker)
+        {
+            const std::string suffix(std::to_string(iWorker));
+            m_sliceNuWorkerPool.push_back(m_shouldRunNeutrinoRecoOption
+                    ? this->CreateWorkerInstance(larTPCMap, gapList, m_nuSettingsFile, "SliceNuWorker" + suffix)
+                    : nullptr);
+            m_sliceCRWorkerPool.push_back(m_shouldRunCosmicRecoOption
+                    ? this->CreateWorkerInstance(larTPCMap, gapList, m_crSettingsFile, "SliceCRWorker" + suffix)
+                    : nullptr);
+        }
     }
     catch (const StatusCodeException &statusCodeException)
     {
@@ -337,6 +947,77 @@ StatusCode MasterThreeDAlgorithm::InitializeWorkerInstances()
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+StatusCode MasterThreeDAlgorithm::UpdateCosmicRayWorkerInstances(const VolumeIdToHitListMap &volumeIdToHitListMap)
+{
+    if (!m_shouldRunAllHitsCosmicReco)
+        return STATUS_CODE_SUCCESS;
+
+    bool workersChanged(false);
+
+    try
+    {
+        const LArTPCMap &larTPCMap(this->GetPandora().GetGeometry()->GetLArTPCMap());
+        const DetectorGapList &gapList(this->GetPandora().GetGeometry()->GetDetectorGapList());
+
+        for (const VolumeIdToHitListMap::value_type &mapEntry : volumeIdToHitListMap)
+        {
+            const unsigned int volumeId(mapEntry.first);
+            m_crWorkerIdleEventsMap[volumeId] = 0;
+
+            if (m_crWorkerInstanceMap.count(volumeId))
+                continue;
+
+            if (m_printOverallRecoStatus)
+                std::cout << "Creating cosmic-ray worker instance for volume " << volumeId << std::endl;
+
+            const std::string name("CRWorkerInstance" + std::to_string(volumeId));
+            m_crWorkerInstanceMap[volumeId] = this->CreateWorkerInstance(*(larTPCMap.at(volumeId)), gapList, m_crSettingsFile, name);
+            workersChanged = true;
+        }
+    }
+    catch (const StatusCodeException &statusCodeException)
+    {
+        std::cout << "MasterAlgorithm: Exception during creation of cosmic-ray worker instances " << statusCodeException.ToString()
+                  << std::endl;
+        return statusCodeException.GetStatusCode();
+    }
+
+    if (m_crWorkerIdleEventLimit > 0)
+    {
+        for (VolumeIdToPandoraMap::iterator iter = m_crWorkerInstanceMap.begin(); iter != m_crWorkerInstanceMap.end();)
+        {
+            unsigned int &nIdleEvents(m_crWorkerIdleEventsMap[iter->first]);
+
+            if (volumeIdToHitListMap.count(iter->first) || (++nIdleEvents < m_crWorkerIdleEventLimit))
+            {
+                ++iter;
+                continue;
+            }
+
+            if (m_printOverallRecoStatus)
+                std::cout << "Releasing cosmic-ray worker instance for volume " << iter->first << std::endl;
+
+            delete iter->second;
+            m_crWorkerIdleEventsMap.erase(iter->first);
+            iter = m_crWorkerInstanceMap.erase(iter);
+            workersChanged = true;
+        }
+    }
+
+    // Keep the workers in volume id order, as if they had all been created up front
+    if (workersChanged)
+    {
+        m_crWorkerInstances.clear();
+
+        for (const VolumeIdToPandoraMap::value_type &mapEntry : m_crWorkerInstanceMap)
+            m_crWorkerInstances.push_back(mapEntry.second);
+    }
+
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 StatusCode MasterThreeDAlgorithm::GetVolumeIdToHitListMap(VolumeIdToHitListMap &volumeIdToHitListMap) const
 {
     const LArTPCMap &larTPCMap(this->GetPandora().GetGeometry()->GetLArTPCMap());
@@ -345,36 +1026,118 @@ StatusCode MasterThreeDAlgorithm::GetVolumeIdToHitListMap(VolumeIdToHitListMap &
     const CaloHitList *pCaloHitList(nullptr);
     PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraContentApi::GetList(*this, m_inputHitListName, pCaloHitList));
 
+    // The x extent of each LArTPC, indexed by volume id
+    const unsigned int nVolumeIds(larTPCMap.empty() ? 0 : larTPCMap.rbegin()->first + 1);
+    std::vector<float> volumeMinX(nVolumeIds, std::numeric_limits<float>::max());
+    std::vector<float> volumeMaxX(nVolumeIds, -std::numeric_limits<float>::max());
+    std::vector<unsigned char> isLArTPCVolume(nVolumeIds, 0);
+
+    for (const LArTPCMap::value_type &mapEntry : larTPCMap)
+    {
+        isLArTPCVolume[mapEntry.first] = 1;
+        volumeMinX[mapEntry.first] = mapEntry.second->GetCenterX() - 0.5f * mapEntry.second->GetWidthX();
+        volumeMaxX[mapEntry.first] = mapEntry.second->GetCenterX() + 0.5f * mapEntry.second->GetWidthX();
+    }
+
+    // The volume of each hit recorded by the application, with the x extent test done in one pass over the recorded hits
+    const LArEventHitVolumes &eventHitVolumes(LArEventHitVolumes::Get());
+    const std::vector<unsigned int> &volumeIds(eventHitVolumes.m_volumeIds);
+    const std::vector<float> &positionsX(eventHitVolumes.m_positionsX);
+    std::vector<unsigned char> isInVolumeX(volumeIds.size(), 0);
+
+    for (size_t iHit = 0; (nVolumeIds > 0) && (iHit < volumeIds.size()); ++iHit)
+    {
+        const unsigned int volumeId(volumeIds[iHit] < nVolumeIds ? volumeIds[iHit] : 0);
+        isInVolumeX[iHit] = (positionsX[iHit] >= volumeMinX[volumeId]) & (positionsX[iHit] <= volumeMaxX[volumeId]);
+    }
+
+    std::map<unsigned int, unsigned int> volumeIdToNOutsideHits;
+
     for (const CaloHit *const pCaloHit : *pCaloHitList)
     {
-        const LArCaloHit *const pLArCaloHit(dynamic_cast<const LArCaloHit *>(pCaloHit));
+        size_t hitIndex(0);
+        unsigned int volumeId(0);
+        bool isInLArTPC(false);
 
-        if (!pLArCaloHit && (1 != nLArTPCs))
-            return STATUS_CODE_INVALID_PARAMETER;
+        if (eventHitVolumes.GetHitIndex(pCaloHit->GetParentAddress(), hitIndex) && (volumeIds[hitIndex] < nVolumeIds) &&
+            isLArTPCVolume[volumeIds[hitIndex]])
+        {
+            volumeId = volumeIds[hitIndex];
+            isInLArTPC = isInVolumeX[hitIndex];
+        }
+        else
+        {
+            // Hits not recorded by the application, or not in a known LArTPC
+            const LArCaloHit *const pLArCaloHit(dynamic_cast<const LArCaloHit *>(pCaloHit));
+
+            if (!pLArCaloHit && (1 != nLArTPCs))
+                return STATUS_CODE_INVALID_PARAMETER;
 
-        const unsigned int volumeId(pLArCaloHit ? pLArCaloHit->GetLArTPCVolumeId() : 0);
-        const LArTPC *const pLArTPC(larTPCMap.at(volumeId));
+            volumeId = pLArCaloHit ? pLArCaloHit->GetLArTPCVolumeId() : 0;
+            const LArTPC *const pLArTPC(larTPCMap.at(volumeId));
+            const float x(pCaloHit->GetPositionVector().GetX());
+            isInLArTPC = (x >= (pLArTPC->GetCenterX() - 0.5f * pLArTPC->GetWidthX())) &&
+                         (x <= (pLArTPC->GetCenterX() + 0.5f * pLArTPC->GetWidthX()));
+        }
 
         LArTPCHitList &larTPCHitList(volumeIdToHitListMap[volumeId]);
         larTPCHitList.m_allHitList.push_back(pCaloHit);
 
-        if (((pCaloHit->GetPositionVector().GetX() >= (pLArTPC->GetCenterX() - 0.5f * pLArTPC->GetWidthX())) &&
-                (pCaloHit->GetPositionVector().GetX() <= (pLArTPC->GetCenterX() + 0.5f * pLArTPC->GetWidthX()))))
+        if (isInLArTPC)
         {
             larTPCHitList.m_truncatedHitList.push_back(pCaloHit);
         }
         else
-            std::cout << "Hit of type " << pCaloHit->GetHitType() << " outside TPC " << volumeId << "? "
-                      << pCaloHit->GetPositionVector().GetX() << ", " << pLArTPC->GetCenterX() - 0.5f * pLArTPC->GetWidthX() << ", "
-                      << pLArTPC->GetCenterX() + 0.5f * pLArTPC->GetWidthX() << std::endl;
+        {
+            ++volumeIdToNOutsideHits[volumeId];
+        }
     }
 
+    for (const std::map<unsigned int, unsigned int>::value_type &mapEntry : volumeIdToNOutsideHits)
+        std::cout << "MasterThreeDAlgorithm: " << mapEntry.second << " hits outside the x extent of TPC " << mapEntry.first << std::endl;
+
     return STATUS_CODE_SUCCESS;
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 StatusCode MasterThreeDAlgorithm::ReadSettings(const pandora::TiXmlHandle xmlHandle)
 {
-    return MasterAlgorithm::ReadSettings(xmlHandle);
+    PANDORA_RETURN_RESULT_IF_AND_IF(STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=,
+        XmlHelper::ReadValue(xmlHandle, "CRWorkerIdleEventLimit", m_crWorkerIdleEventLimit));
+
+    PANDORA_RETURN_RESULT_IF_AND_IF(
+        STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle, "NCRWorkerThreads", m_nCRWorkerThreads));
+
+    PANDORA_RETURN_RESULT_IF_AND_IF(
+        STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle, "NSliceWorkers", m_nSliceWorkers));
+
+    PANDORA_RETURN_RESULT_IF_AND_IF(
+        STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle, "EventTimeBudget", m_eventTimeBudget));
+
+    PANDORA_RETURN_RESULT_IF_AND_IF(
+        STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle, "BudgetMaxSliceHits", m_budgetMaxSliceHits));
+
+    PANDORA_RETURN_RESULT_IF_AND_IF(
+        STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle, "SliceOutputFileName", m_sliceOutputFileName));
+
+    PANDORA_RETURN_RESULT_IF_AND_IF(
+        STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle, "SliceInputFileName", m_sliceInputFileName));
+
+    if (!m_sliceOutputFileName.empty() && !m_sliceInputFileName.empty())
+    {
+        std::cout << "MasterThreeDAlgorithm: cannot both write and read a slice file" << std::endl;
+        return STATUS_CODE_INVALID_PARAMETER;
+    }
+
+    PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, MasterAlgorithm::ReadSettings(xmlHandle));
+
+    // If the application created the geometry before reading the settings, as LArRecoND does, the worker instances are made now
+    // rather than on the first event, so that child processes forked after initialisation share them
+    if (!this->GetPandora().GetGeometry()->GetLArTPCMap().empty())
+        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->InitializeWorkerInstances());
+
+    return STATUS_CODE_SUCCESS;
 }
 
 } // namespace lar_content
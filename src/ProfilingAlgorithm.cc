@@ -0,0 +1,80 @@
+/**
+ *  @file   src/ProfilingAlgorithm.cc
+ *
+ *  @brief  Implementation of the algorithm timing its daughter algorithms.
+ *
+ *  $Log: $
+ */
+
+#include "Pandora/AlgorithmHeaders.h"
+
+#include "LArProfile.h"
+#include "ProfilingAlgorithm.h"
+
+using namespace pandora;
+
+namespace lar_content
+{
+
+ProfilingAlgorithm::ProfilingAlgorithm()
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode ProfilingAlgorithm::Run()
+{
+    LArProfile &profile(LArProfile::Get());
+
+    for (unsigned int iAlgorithm = 0; iAlgorithm < m_algorithmNames.size(); ++iAlgorithm)
+    {
+        if (!profile.IsEnabled())
+        {
+            PANDORA_RETURN_RESULT_IF(
+                STATUS_CODE_SUCCESS, !=, PandoraContentApi::RunDaughterAlgorithm(*this, m_algorithmNames.at(iAlgorithm)));
+            continue;
+        }
+
+        // The number of hits in the current list as the daughter algorithm starts, if there is a current list
+        const CaloHitList *pCaloHitList(nullptr);
+        const StatusCode listStatusCode(PandoraContentApi::GetCurrentList(*this, pCaloHitList));
+        const int nHits((STATUS_CODE_SUCCESS == listStatusCode) && pCaloHitList ? static_cast<int>(pCaloHitList->size()) : 0);
+
+        const double startWallTime(LArProfile::GetWallTime()), startCPUTime(LArProfile::GetCPUTime());
+        const StatusCode statusCode(PandoraContentApi::RunDaughterAlgorithm(*this, m_algorithmNames.at(iAlgorithm)));
+        profile.AddEntry(&this->GetPandora(), m_algorithmTypes.at(iAlgorithm), nHits, LArProfile::GetWallTime() - startWallTime,
+            LArProfile::GetCPUTime() - startCPUTime);
+
+        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, statusCode);
+    }
+
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode ProfilingAlgorithm::ReadSettings(const TiXmlHandle xmlHandle)
+{
+    const TiXmlHandle algorithmListHandle(xmlHandle.FirstChild("algorithms").Element());
+
+    for (TiXmlElement *pXmlElement = algorithmListHandle.FirstChild("algorithm").Element(); nullptr != pXmlElement;
+         pXmlElement = pXmlElement->NextSiblingElement("algorithm"))
+    {
+        std::string algorithmName;
+        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraContentApi::CreateDaughterAlgorithm(*this, pXmlElement, algorithmName));
+
+        const char *const pAlgorithmType(pXmlElement->Attribute("type"));
+        m_algorithmNames.push_back(algorithmName);
+        m_algorithmTypes.push_back(pAlgorithmType ? std::string(pAlgorithmType) : algorithmName);
+    }
+
+    if (m_algorithmNames.empty())
+    {
+        std::cout << "ProfilingAlgorithm: no daughter algorithms in the algorithms list" << std::endl;
+        return STATUS_CODE_INVALID_PARAMETER;
+    }
+
+    return STATUS_CODE_SUCCESS;
+}
+
+} // namespace lar_content
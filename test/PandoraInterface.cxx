@@ -40,6 +40,8 @@
 
 #include "LArNDContent.h"
 #include "LArNDGeomSimple.h"
+#include "LArObjectPool.h"
+#include "LArProfile.h"
 #include "LArRay.h"
 #include "PandoraInterface.h"
 
@@ -47,13 +49,27 @@
 #include "TApplication.h"
 #endif
 
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
 #include <algorithm>
+#include <cerrno>
 #include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
 #include <getopt.h>
+#include <iomanip>
 #include <iostream>
 #include <memory>
+#include <numeric>
 #include <random>
+#include <sstream>
 #include <string>
+#include <tuple>
+#include <unordered_map>
 #include <vector>
 
 using namespace pandora;
@@ -81,6 +97,12 @@ int main(int argc, char *argv[])
         if (!pPrimaryPandora)
             throw StatusCodeException(STATUS_CODE_FAILURE);
 
+        if (!parameters.m_profileFileName.empty())
+        {
+            lar_content::LArProfile::Get().Enable(parameters.m_profileFileName);
+            lar_content::LArProfile::Get().SetInstanceName(pPrimaryPandora, "Primary");
+        }
+
         PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, LArContent::RegisterAlgorithms(*pPrimaryPandora));
 #ifdef LIBTORCH_DL
         PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, LArDLContent::RegisterAlgorithms(*pPrimaryPandora));
@@ -94,13 +116,54 @@ int main(int argc, char *argv[])
 
         LArNDGeomSimple simpleGeom;
         CreateGeometry(parameters, pPrimaryPandora, simpleGeom);
-        ProcessExternalParameters(parameters, pPrimaryPandora);
-        PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::SetPseudoLayerPlugin(*pPrimaryPandora, new lar_content::LArPseudoLayerPlugin));
-        PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=,
-            PandoraApi::SetLArTransformationPlugin(*pPrimaryPandora, new lar_content::LArRotationalTransformationPlugin));
-        PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::ReadSettings(*pPrimaryPandora, parameters.m_settingsFile));
 
-        ProcessEvents(parameters, pPrimaryPandora, simpleGeom);
+        if (!parameters.m_onlyWriteGeomCache)
+        {
+            ProcessExternalParameters(parameters, pPrimaryPandora);
+            PANDORA_THROW_RESULT_IF(
+                STATUS_CODE_SUCCESS, !=, PandoraApi::SetPseudoLayerPlugin(*pPrimaryPandora, new lar_content::LArPseudoLayerPlugin));
+            PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=,
+                PandoraApi::SetLArTransformationPlugin(*pPrimaryPandora, new lar_content::LArRotationalTransformationPlugin));
+            PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::ReadSettings(*pPrimaryPandora, parameters.m_settingsFile));
+
+            const bool isServer(!parameters.m_serverSpoolName.empty());
+
+            if ((isServer || (parameters.m_nProcesses > 1)) && WritesFixedValidationOutput(parameters.m_settingsFile))
+            {
+                // Each child would write, and the parent rewrite, the same validation files at the end of the process, and a server
+                // would collect the validation of every job into them
+                std::cout << "Error: the validation trees cannot be written with -P or -S; turn off their writing in the settings"
+                          << std::endl;
+                errorNo = 1;
+            }
+            else if (isServer)
+            {
+                // Process a queue of input files, keeping the initialised state between them
+                errorNo = RunServer(parameters, pPrimaryPandora, simpleGeom);
+            }
+            else if (parameters.m_nProcesses > 1)
+            {
+                // Share the events between child processes, which all start from the state initialised above
+                LArChildProcessList childProcesses;
+                Parameters childParameters(parameters);
+                int resultFd(-1);
+                childParameters.m_processIndex = ForkChildProcesses(parameters, childProcesses, resultFd);
+
+                if (childParameters.m_processIndex < 0)
+                {
+                    errorNo = WaitForChildProcesses(parameters, childProcesses);
+                }
+                else
+                {
+                    ProcessEvents(childParameters, pPrimaryPandora, simpleGeom);
+                    ReportChildProcessEvents(resultFd);
+                }
+            }
+            else
+            {
+                ProcessEvents(parameters, pPrimaryPandora, simpleGeom);
+            }
+        }
     }
     catch (const StatusCodeException &statusCodeException)
     {
@@ -113,6 +176,7 @@ int main(int argc, char *argv[])
         errorNo = 1;
     }
 
+    lar_content::LArProfile::Get().PrintSummary();
     MultiPandoraApi::DeletePandoraInstances(pPrimaryPandora);
     return errorNo;
 }
@@ -124,6 +188,22 @@ namespace lar_nd_reco
 
 void CreateGeometry(const Parameters &parameters, const Pandora *const pPrimaryPandora, LArNDGeomSimple &geom)
 {
+    // Use the cached TPC volumes, unless they are missing or were made from a different geometry or options
+    std::uint64_t checksum(0);
+    const bool useGeomCache(!parameters.m_geomCacheFileName.empty() && GetGeometryChecksum(parameters, checksum));
+    LArGeometryCache geomCache(checksum);
+
+    if (useGeomCache && !parameters.m_onlyWriteGeomCache && geomCache.Read(parameters.m_geomCacheFileName))
+    {
+        for (const LArCachedTPC &tpc : geomCache.GetTPCs())
+            MakePandoraTPC(pPrimaryPandora, geom, tpc);
+
+        std::cout << "Created " << geomCache.GetTPCs().size() << " TPCs from the geometry cache " << parameters.m_geomCacheFileName
+                  << std::endl;
+        geom.BuildIndex();
+        return;
+    }
+
     // Get the geometry info from the appropriate ROOT file
     TFile *fileSource = TFile::Open(parameters.m_geomFileName.c_str(), "READ");
     if (!fileSource)
@@ -162,7 +242,7 @@ void CreateGeometry(const Parameters &parameters, const Pandora *const pPrimaryP
         }
         const TGeoNode *pTargetNode = pSimGeom->GetCurrentNode();
 
-        MakePandoraTPC(pPrimaryPandora, parameters, geom, pVolMatrix, pTargetNode, n);
+        MakePandoraTPC(pPrimaryPandora, parameters, geom, pVolMatrix, pTargetNode, n, geomCache);
 
         for (const unsigned int &daughter : nodePaths.at(n))
         {
@@ -172,7 +252,19 @@ void CreateGeometry(const Parameters &parameters, const Pandora *const pPrimaryP
     }
     std::cout << "Created " << nodePaths.size() << " TPCs" << std::endl;
 
+    // Spatial index for the TPC lookup of each voxel or space point
+    geom.BuildIndex();
+
     fileSource->Close();
+
+    if (useGeomCache)
+    {
+        if (geomCache.Write(parameters.m_geomCacheFileName))
+            std::cout << "Wrote " << geomCache.GetTPCs().size() << " TPCs to the geometry cache " << parameters.m_geomCacheFileName
+                      << std::endl;
+        else
+            std::cout << "Error in CreateGeometry(): can't write geometry cache " << parameters.m_geomCacheFileName << std::endl;
+    }
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -202,7 +294,7 @@ void RecursiveGeometrySearch(TGeoManager *pSimGeom, const std::string &targetNam
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 void MakePandoraTPC(const pandora::Pandora *const pPrimaryPandora, const Parameters &parameters, LArNDGeomSimple &geom,
-    const std::unique_ptr<TGeoHMatrix> &pVolMatrix, const TGeoNode *pTargetNode, const unsigned int tpcNumber)
+    const std::unique_ptr<TGeoHMatrix> &pVolMatrix, const TGeoNode *pTargetNode, const unsigned int tpcNumber, LArGeometryCache &geomCache)
 {
     // Get the BBox dimensions from the placement volume, which is assumed to be a cube
     TGeoVolume *pCurrentVol = pTargetNode->GetVolume();
@@ -224,15 +316,37 @@ void MakePandoraTPC(const pandora::Pandora *const pPrimaryPandora, const Paramet
 
     // std::cout << "Level1 = (" << level1[0] << ", " << level1[1] << ", " << level1[2] << ")" << std::endl;
 
+    const double *pVolTrans = pVolMatrix->GetTranslation();
+    LArCachedTPC tpc;
+    tpc.m_tpcID = tpcNumber;
+    tpc.m_centreX = (level1[0] + pVolTrans[0]) * parameters.m_lengthScale;
+    tpc.m_centreY = (level1[1] + pVolTrans[1]) * parameters.m_lengthScale;
+    tpc.m_centreZ = (level1[2] + pVolTrans[2]) * parameters.m_lengthScale;
+    tpc.m_halfWidthX = dx;
+    tpc.m_halfWidthY = dy;
+    tpc.m_halfWidthZ = dz;
+
+    geomCache.AddTPC(tpc);
+    MakePandoraTPC(pPrimaryPandora, geom, tpc);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void MakePandoraTPC(const pandora::Pandora *const pPrimaryPandora, LArNDGeomSimple &geom, const LArCachedTPC &tpc)
+{
+    const unsigned int tpcNumber = tpc.m_tpcID;
+    const double dx = tpc.m_halfWidthX;
+    const double dy = tpc.m_halfWidthY;
+    const double dz = tpc.m_halfWidthZ;
+
     // Can now create a geometry using the found parameters
     PandoraApi::Geometry::LArTPC::Parameters geoparameters;
 
     try
     {
-        const double *pVolTrans = pVolMatrix->GetTranslation();
-        const double centreX = (level1[0] + pVolTrans[0]) * parameters.m_lengthScale;
-        const double centreY = (level1[1] + pVolTrans[1]) * parameters.m_lengthScale;
-        const double centreZ = (level1[2] + pVolTrans[2]) * parameters.m_lengthScale;
+        const double centreX = tpc.m_centreX;
+        const double centreY = tpc.m_centreY;
+        const double centreZ = tpc.m_centreZ;
         geoparameters.m_centerX = centreX;
         geoparameters.m_centerY = centreY;
         geoparameters.m_centerZ = centreZ;
@@ -275,6 +389,430 @@ void MakePandoraTPC(const pandora::Pandora *const pPrimaryPandora, const Paramet
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+bool GetGeometryChecksum(const Parameters &parameters, std::uint64_t &checksum)
+{
+    // The TPC volumes depend on the geometry file and on the options used to find and scale them
+    std::ostringstream options;
+    options << std::setprecision(9) << parameters.m_geomManagerName << "\n"
+            << (parameters.m_useModularGeometry ? parameters.m_sensitiveDetName : parameters.m_geometryVolName) << "\n"
+            << parameters.m_useModularGeometry << "\n"
+            << parameters.m_lengthScale;
+
+    return LArGeometryCache::GetChecksum(parameters.m_geomFileName, options.str(), checksum);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool WritesFixedValidationOutput(const std::string &settingsFile)
+{
+    TiXmlDocument xmlDocument(settingsFile.c_str());
+    if (!xmlDocument.LoadFile() || !xmlDocument.FirstChildElement())
+        return false;
+
+    bool writesFixedOutput(false);
+
+    // The LArContent validation algorithms and the settings that make them write their trees
+    const std::vector<std::pair<std::string, std::vector<std::string>>> validationAlgorithms{
+        {"LArHierarchyValidation", {"WriteMCTree", "WriteEventTree"}}, {"LArNeutrinoEventValidation", {"WriteToTree"}}};
+
+    // Search all of the algorithms, including the daughters of algorithms such as LArProfiling
+    std::vector<const TiXmlElement *> elements(1, xmlDocument.FirstChildElement());
+
+    while (!elements.empty())
+    {
+        const TiXmlElement *const pElement(elements.back());
+        elements.pop_back();
+
+        for (const TiXmlElement *pChild = pElement->FirstChildElement(); pChild; pChild = pChild->NextSiblingElement())
+            elements.push_back(pChild);
+
+        const char *const pType(pElement->Attribute("type"));
+        if (("algorithm" != std::string(pElement->Value())) || !pType)
+            continue;
+
+        for (const auto &validationAlgorithm : validationAlgorithms)
+        {
+            if (validationAlgorithm.first != pType)
+                continue;
+
+            for (const std::string &writeSetting : validationAlgorithm.second)
+            {
+                const TiXmlElement *const pSetting(pElement->FirstChildElement(writeSetting.c_str()));
+                const std::string value(pSetting && pSetting->GetText() ? pSetting->GetText() : "");
+
+                if (("true" == value) || ("1" == value))
+                {
+                    std::cout << pType << " writes " << writeSetting << " to a fixed file name in " << settingsFile << std::endl;
+                    writesFixedOutput = true;
+                }
+            }
+        }
+    }
+
+    return writesFixedOutput;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+int ForkChildProcesses(const Parameters &parameters, LArChildProcessList &childProcesses, int &resultFd)
+{
+    // Flush any buffered output, so that it is not repeated by each child
+    std::cout.flush();
+    std::cerr.flush();
+    std::fflush(nullptr);
+
+    for (int shardIndex = 0; shardIndex < parameters.m_nProcesses; ++shardIndex)
+    {
+        int pipeFds[2] = {-1, -1};
+        if (0 != pipe(pipeFds))
+        {
+            std::cout << "Error in ForkChildProcesses(): can't create pipe for child process " << shardIndex << std::endl;
+            break;
+        }
+
+        const pid_t pid(fork());
+        if (pid < 0)
+        {
+            std::cout << "Error in ForkChildProcesses(): can't fork child process " << shardIndex << std::endl;
+            close(pipeFds[0]);
+            close(pipeFds[1]);
+            break;
+        }
+
+        if (0 == pid)
+        {
+            // Child process: only keep the write end of its own pipe
+            close(pipeFds[0]);
+            for (const LArChildProcess &childProcess : childProcesses)
+                close(childProcess.m_resultFd);
+
+            childProcesses.clear();
+            resultFd = pipeFds[1];
+
+            lar_content::LArProcessShard &processShard(lar_content::LArProcessShard::Get());
+            processShard.m_role = lar_content::LArProcessShard::CHILD;
+            processShard.m_shardIndex = shardIndex;
+            processShard.m_nProcesses = parameters.m_nProcesses;
+            return shardIndex;
+        }
+
+        close(pipeFds[1]);
+        childProcesses.push_back({shardIndex, pid, pipeFds[0], std::chrono::steady_clock::now()});
+        std::cout << "Forked child process " << shardIndex << " with pid " << pid << std::endl;
+    }
+
+    lar_content::LArProcessShard::Get().m_role = lar_content::LArProcessShard::PARENT;
+    return -1;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+int WaitForChildProcesses(const Parameters &parameters, const LArChildProcessList &childProcesses)
+{
+    int errorNo(static_cast<int>(childProcesses.size()) == parameters.m_nProcesses ? 0 : 1);
+    size_t nRunning(childProcesses.size());
+
+    while (nRunning > 0)
+    {
+        int status(0);
+        const pid_t pid(waitpid(-1, &status, 0));
+
+        if (pid < 0)
+        {
+            if (EINTR == errno)
+                continue;
+
+            std::cout << "Error in WaitForChildProcesses(): lost track of " << nRunning << " child processes" << std::endl;
+            return 1;
+        }
+
+        const auto iter(std::find_if(childProcesses.begin(), childProcesses.end(),
+            [pid](const LArChildProcess &childProcess) { return childProcess.m_pid == pid; }));
+
+        if (childProcesses.end() == iter)
+            continue;
+
+        --nRunning;
+        const std::chrono::duration<double> duration(std::chrono::steady_clock::now() - iter->m_startTime);
+
+        // A child that did not finish has not written its number of events
+        int nEvents(-1);
+        if (static_cast<ssize_t>(sizeof(nEvents)) != read(iter->m_resultFd, &nEvents, sizeof(nEvents)))
+            nEvents = -1;
+
+        close(iter->m_resultFd);
+
+        const bool succeeded(WIFEXITED(status) && (0 == WEXITSTATUS(status)) && (nEvents >= 0));
+        if (!succeeded)
+            errorNo = 1;
+
+        std::cout << "Child process " << iter->m_shardIndex << " (pid " << pid << ") " << (succeeded ? "finished" : "failed") << " after "
+                  << duration.count() << " s";
+
+        if (succeeded)
+        {
+            const double eventRate(duration.count() > 0. ? nEvents / duration.count() : 0.);
+            std::cout << ", processing " << nEvents << " events (" << eventRate << " events/s)";
+        }
+
+        std::cout << std::endl;
+    }
+
+    return errorNo;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void ReportChildProcessEvents(const int resultFd)
+{
+    const int nEvents(lar_content::LArProcessShard::Get().m_nEvents);
+
+    if (static_cast<ssize_t>(sizeof(nEvents)) != write(resultFd, &nEvents, sizeof(nEvents)))
+        std::cout << "Error in ReportChildProcessEvents(): can't report the number of events" << std::endl;
+
+    close(resultFd);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void GetProcessEventRange(
+    const Parameters &parameters, const int startEvt, const int endEvt, int &firstEvt, int &lastEvt, int &eventStride)
+{
+    firstEvt = startEvt;
+    lastEvt = endEvt;
+    eventStride = 1;
+
+    if (parameters.m_processIndex >= 0)
+    {
+        if (parameters.m_blockPartitionEvents)
+        {
+            const int blockSize((endEvt - startEvt + parameters.m_nProcesses - 1) / parameters.m_nProcesses);
+            firstEvt = std::min(endEvt, startEvt + parameters.m_processIndex * blockSize);
+            lastEvt = std::min(endEvt, firstEvt + blockSize);
+        }
+        else
+        {
+            firstEvt = startEvt + parameters.m_processIndex;
+            eventStride = parameters.m_nProcesses;
+        }
+
+        std::cout << "Child process " << parameters.m_processIndex << " processes every " << eventStride << " event(s) from " << firstEvt
+                  << " to " << lastEvt - 1 << std::endl;
+    }
+
+    // Used by the output algorithms to find the input events of this process
+    lar_content::LArProcessShard &processShard(lar_content::LArProcessShard::Get());
+    processShard.m_eventOffset = firstEvt - startEvt;
+    processShard.m_eventStride = eventStride;
+    processShard.m_nEvents = (lastEvt > firstEvt) ? (lastEvt - firstEvt + eventStride - 1) / eventStride : 0;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+int RunServer(const Parameters &parameters, const Pandora *const pPrimaryPandora, const LArNDGeomSimple &geom)
+{
+    struct stat spoolStat;
+    if ((0 != stat(parameters.m_serverSpoolName.c_str(), &spoolStat)) || !(S_ISDIR(spoolStat.st_mode) || S_ISFIFO(spoolStat.st_mode)))
+    {
+        std::cout << "Error in RunServer(): " << parameters.m_serverSpoolName << " is not a spool directory or control FIFO" << std::endl;
+        return 1;
+    }
+
+    const bool useControlFifo(S_ISFIFO(spoolStat.st_mode));
+    std::ifstream controlFifo;
+    lar_content::LArServerJob &serverJob(lar_content::LArServerJob::Get());
+    int errorNo(0);
+
+    std::cout << "Server waiting for jobs from " << parameters.m_serverSpoolName << std::endl;
+
+    while (true)
+    {
+        std::string jobFileName, inputFileName, outputFileName;
+        const bool gotJob(useControlFifo ? GetNextFifoServerJob(parameters, controlFifo, inputFileName, outputFileName)
+                                         : GetNextSpoolServerJob(parameters, jobFileName, inputFileName, outputFileName));
+        if (!gotJob)
+            break;
+
+        // Used by the output algorithms to read the events and write the output of this job
+        ++serverJob.m_jobNumber;
+        serverJob.m_inputFileName = inputFileName;
+        serverJob.m_outputFileName = outputFileName;
+        serverJob.m_isFinished = false;
+        lar_content::LArProcessShard::Get().m_nEvents = -1;
+
+        Parameters jobParameters(parameters);
+        jobParameters.m_inputFileName = inputFileName;
+
+        std::cout << "Server job " << serverJob.m_jobNumber << ": processing " << inputFileName << " into " << outputFileName << std::endl;
+        const std::chrono::steady_clock::time_point startTime(std::chrono::steady_clock::now());
+        bool succeeded(true);
+
+        try
+        {
+            ProcessEvents(jobParameters, pPrimaryPandora, geom);
+        }
+        catch (const StatusCodeException &statusCodeException)
+        {
+            std::cerr << "Pandora StatusCodeException in server job " << serverJob.m_jobNumber << ": " << statusCodeException.ToString()
+                      << statusCodeException.GetBackTrace() << std::endl;
+            succeeded = false;
+        }
+        catch (...)
+        {
+            std::cerr << "Unknown exception in server job " << serverJob.m_jobNumber << std::endl;
+            succeeded = false;
+        }
+
+        // The extra reset lets the output algorithms write the output of the finished job, and clears a failed event
+        serverJob.m_isFinished = true;
+        if (STATUS_CODE_SUCCESS != PandoraApi::Reset(*pPrimaryPandora))
+            succeeded = false;
+
+        // The number of events is only set once the input file has been opened
+        const int nEvents(lar_content::LArProcessShard::Get().m_nEvents);
+        succeeded = succeeded && (nEvents >= 0);
+
+        if (!succeeded)
+            errorNo = 1;
+
+        const std::chrono::duration<double> duration(std::chrono::steady_clock::now() - startTime);
+        WriteServerJobMarker(inputFileName, outputFileName, succeeded, std::max(nEvents, 0), duration.count());
+
+        if (!jobFileName.empty())
+            std::remove(jobFileName.c_str());
+
+        std::cout << "Server job " << serverJob.m_jobNumber << " " << (succeeded ? "finished" : "failed") << " after " << duration.count()
+                  << " s" << std::endl;
+    }
+
+    std::cout << "Server stopped after " << serverJob.m_jobNumber << " jobs" << std::endl;
+    return errorNo;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool GetNextSpoolServerJob(const Parameters &parameters, std::string &jobFileName, std::string &inputFileName, std::string &outputFileName)
+{
+    const std::string spoolName(parameters.m_serverSpoolName + "/");
+    const std::string jobExtension(".job");
+
+    while (true)
+    {
+        DIR *pSpoolDir(opendir(spoolName.c_str()));
+        if (!pSpoolDir)
+        {
+            std::cout << "Error in GetNextSpoolServerJob(): can't read spool directory " << spoolName << std::endl;
+            return false;
+        }
+
+        bool shouldStop(false);
+        std::vector<std::string> jobNames;
+
+        while (const struct dirent *pEntry = readdir(pSpoolDir))
+        {
+            const std::string entryName(pEntry->d_name);
+
+            if ("stop" == entryName)
+                shouldStop = true;
+            else if ((entryName.size() > jobExtension.size()) &&
+                (0 == entryName.compare(entryName.size() - jobExtension.size(), jobExtension.size(), jobExtension)))
+                jobNames.emplace_back(entryName);
+        }
+
+        closedir(pSpoolDir);
+
+        // Stop between jobs, leaving any remaining jobs for the next server
+        if (shouldStop)
+        {
+            std::remove((spoolName + "stop").c_str());
+            return false;
+        }
+
+        std::sort(jobNames.begin(), jobNames.end());
+
+        for (const std::string &jobName : jobNames)
+        {
+            // Claim the job, which fails if another server sharing the spool directory has already claimed it
+            const std::string runningName(spoolName + jobName + ".running");
+            if (0 != std::rename((spoolName + jobName).c_str(), runningName.c_str()))
+                continue;
+
+            std::ifstream jobFile(runningName);
+            if (jobFile >> inputFileName >> outputFileName)
+            {
+                jobFileName = runningName;
+                return true;
+            }
+
+            std::cout << "Error in GetNextSpoolServerJob(): can't read input and output file names from " << jobName << std::endl;
+            std::rename(runningName.c_str(), (spoolName + jobName + ".invalid").c_str());
+        }
+
+        sleep(1);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool GetNextFifoServerJob(const Parameters &parameters, std::ifstream &controlFifo, std::string &inputFileName, std::string &outputFileName)
+{
+    while (true)
+    {
+        // Opening the FIFO waits for a writer, and reading the end of it means that all of the writers have closed it
+        if (!controlFifo.is_open())
+        {
+            controlFifo.clear();
+            controlFifo.open(parameters.m_serverSpoolName);
+
+            if (!controlFifo.is_open())
+            {
+                std::cout << "Error in GetNextFifoServerJob(): can't open control FIFO " << parameters.m_serverSpoolName << std::endl;
+                return false;
+            }
+        }
+
+        std::string jobLine;
+        if (!std::getline(controlFifo, jobLine))
+        {
+            controlFifo.close();
+            continue;
+        }
+
+        // Skip blank and comment lines
+        std::istringstream jobStream(jobLine);
+        if (!(jobStream >> inputFileName) || ('#' == inputFileName.front()))
+            continue;
+
+        if ("stop" == inputFileName)
+            return false;
+
+        if (jobStream >> outputFileName)
+            return true;
+
+        std::cout << "Error in GetNextFifoServerJob(): no output file name in job " << jobLine << std::endl;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void WriteServerJobMarker(
+    const std::string &inputFileName, const std::string &outputFileName, const bool succeeded, const int nEvents, const double seconds)
+{
+    // Write to a temporary file first, so that the marker only appears once complete
+    const std::string markerName(outputFileName + ".done");
+    const std::string tmpMarkerName(markerName + ".tmp");
+
+    std::ofstream markerFile(tmpMarkerName, std::ios::trunc);
+    markerFile << inputFileName << " " << outputFileName << " " << (succeeded ? "ok" : "failed") << " " << nEvents << " " << seconds
+               << std::endl;
+    markerFile.close();
+
+    if (!markerFile || (0 != std::rename(tmpMarkerName.c_str(), markerName.c_str())))
+        std::cout << "Error in WriteServerJobMarker(): can't write " << markerName << std::endl;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 void ProcessEvents(const Parameters &parameters, const Pandora *const pPrimaryPandora, const LArNDGeomSimple &geom)
 {
     if (parameters.m_dataFormat == Parameters::LArNDFormat::EDepSim)
@@ -317,11 +855,15 @@ void ProcessSPEvents(const Parameters &parameters, const Pandora *const pPrimary
         parameters.m_dataFormat == Parameters::LArNDFormat::SPMC ? std::make_unique<LArSPMC>(ndsptree) : std::make_unique<LArSP>(ndsptree);
 
     // Factory for creating LArCaloHits
-    lar_content::LArCaloHitFactory m_larCaloHitFactory;
+    lar_content::LArPooledCaloHitFactory m_larCaloHitFactory;
 
     // Voxel width
     const float voxelWidth(parameters.m_voxelWidth);
 
+    // Projection of space point positions onto the wire coordinates
+    const LArWireProjection wireProjection(pPrimaryPandora->GetPlugins()->GetLArTransformationPlugin());
+    std::vector<float> uPositions, vPositions, wPositions;
+
     // Total number of entries in the TTree
     const int nEntries(ndsptree->GetEntries());
 
@@ -334,160 +876,252 @@ void ProcessSPEvents(const Parameters &parameters, const Pandora *const pPrimary
 
     std::cout << "Start event is " << startEvt << " and end event is " << endEvt - 1 << std::endl;
 
-    for (int iEvt = startEvt; iEvt < endEvt; iEvt++)
+    // The events of this process, if they are shared between child processes
+    int firstEvt(startEvt), lastEvt(endEvt), eventStride(1);
+    GetProcessEventRange(parameters, startEvt, endEvt, firstEvt, lastEvt, eventStride);
+
+    for (int iEvt = firstEvt; iEvt < lastEvt; iEvt += eventStride)
     {
         if (parameters.m_shouldDisplayEventNumber)
             std::cout << std::endl << "   PROCESSING EVENT: " << iEvt << std::endl << std::endl;
 
         ndsptree->GetEntry(iEvt);
 
-        // Stop processing the event if we have too many space points: reco takes too long
-        const int nSP = larsp->m_x->size();
-        if (parameters.m_maxMergedVoxels > 0 && nSP > parameters.m_maxMergedVoxels)
-        {
-            std::cout << "SKIPPING EVENT: number of space points " << nSP << " > " << parameters.m_maxMergedVoxels << std::endl;
-            continue;
-        }
-        // Also stop processing the event if it has too few hits (we can't make CaloHits for essentially empty events)
-        if (nSP < parameters.m_minNSpacePoints)
-        {
-            std::cout << "SKIPPING EVENT: number of space points " << nSP << " < " << parameters.m_minNSpacePoints << std::endl;
-            continue;
-        }
+        // Used to key the event records on the input entry, which the event count does not follow once events are skipped
+        lar_content::LArProcessShard::Get().m_eventEntry = iEvt - startEvt;
 
-        // Some truth information first
-        if (parameters.m_dataFormat == Parameters::LArNDFormat::SPMC)
-        {
-            LArSPMC *larspmc = dynamic_cast<LArSPMC *>(larsp.get());
-            CreateSPMCParticles(*larspmc, pPrimaryPandora, parameters);
-        }
+        // Reconstruct each group of space points separated in time as its own sub-event, if required, or else the whole spill
+        LArTimeWindowList timeWindows;
+        MakeSpacePointTimeWindows(*larsp, parameters, timeWindows);
+        lar_content::LArSubEvent::Get().Clear();
 
-        int hitCounter(0);
+        const bool isSubEvent(!timeWindows.empty());
+        const size_t nSubEvents(isSubEvent ? timeWindows.size() : 1);
+        const std::vector<size_t> noWindowSPs;
+        bool isNewSpill(true);
 
-        // Loop over the space points and make them into caloHits
-        for (size_t isp = 0; isp < nSP; ++isp)
+        for (size_t iSubEvent = 0; iSubEvent < nSubEvents; ++iSubEvent)
         {
-            const float voxelX = (*larsp->m_x)[isp];
-            const float voxelY = (*larsp->m_y)[isp];
-            const float voxelZ = (*larsp->m_z)[isp];
-            const float voxelE = (*larsp->m_charge)[isp];
+            const std::vector<size_t> &windowSPs(isSubEvent ? timeWindows[iSubEvent].m_spIndices : noWindowSPs);
 
-            // Skip this hit if its coordinates or energy are NaNs
-            if (std::isnan(voxelX) || std::isnan(voxelY) || std::isnan(voxelZ) || std::isnan(voxelE))
+            // Stop processing the event if it has too few hits (we can't make CaloHits for essentially empty events)
+            const int nSP = isSubEvent ? windowSPs.size() : larsp->m_x->size();
+            if (nSP < parameters.m_minNSpacePoints)
             {
-                std::cout << "Ignoring hit " << isp << " which contains NaNs: (" << voxelX << ", " << voxelY << ", " << voxelZ
-                          << "), E = " << voxelE << std::endl;
+                std::cout << "SKIPPING EVENT: number of space points " << nSP << " < " << parameters.m_minNSpacePoints << std::endl;
                 continue;
             }
 
-            const pandora::CartesianVector voxelPos(voxelX, voxelY, voxelZ);
-            const float MipE{0.00075};
-            const float voxelMipEquivalentE = voxelE / MipE;
-            const int tpcID(geom.GetTPCNumber(voxelPos));
-            lar_content::LArCaloHitParameters caloHitParameters;
-            caloHitParameters.m_positionVector = voxelPos;
-            caloHitParameters.m_expectedDirection = pandora::CartesianVector(0.f, 0.f, 1.f);
-            caloHitParameters.m_cellNormalVector = pandora::CartesianVector(0.f, 0.f, 1.f);
-            caloHitParameters.m_cellGeometry = pandora::RECTANGULAR;
-            caloHitParameters.m_cellSize0 = voxelWidth;
-            caloHitParameters.m_cellSize1 = voxelWidth;
-            caloHitParameters.m_cellThickness = voxelWidth;
-            caloHitParameters.m_nCellRadiationLengths = 1.f;
-            caloHitParameters.m_nCellInteractionLengths = 1.f;
-            caloHitParameters.m_time = 0.f;
-            caloHitParameters.m_inputEnergy = voxelE;
-            caloHitParameters.m_mipEquivalentEnergy = voxelMipEquivalentE;
-            caloHitParameters.m_electromagneticEnergy = voxelE;
-            caloHitParameters.m_hadronicEnergy = voxelE;
-            caloHitParameters.m_isDigital = false;
-            caloHitParameters.m_hitType = pandora::TPC_3D;
-            caloHitParameters.m_hitRegion = pandora::SINGLE_REGION;
-            caloHitParameters.m_layer = 0;
-            caloHitParameters.m_isInOuterSamplingLayer = false;
-            caloHitParameters.m_pParentAddress = (void *)(static_cast<uintptr_t>(++hitCounter));
-            caloHitParameters.m_larTPCVolumeId = tpcID < 0 ? 0 : tpcID;
-            caloHitParameters.m_daughterVolumeId = 0;
+            // If we have too many space points, reco takes too long: merge them into coarser cells if allowed, otherwise skip the event
+            std::vector<size_t> spIndices;
+            std::vector<float> coarseX, coarseY, coarseZ, coarseCharge;
+            float eventVoxelWidth(voxelWidth);
+            const bool isCoarsened(parameters.m_maxMergedVoxels > 0 && nSP > parameters.m_maxMergedVoxels);
+            if (isCoarsened &&
+                !CoarsenSpacePoints(*larsp, windowSPs, parameters, spIndices, coarseX, coarseY, coarseZ, coarseCharge, eventVoxelWidth))
+            {
+                std::cout << "SKIPPING EVENT: number of space points " << nSP << " > " << parameters.m_maxMergedVoxels << std::endl;
+                continue;
+            }
 
-            // Only used for truth
-            long trackID{0};
-            float energyFrac{0.f};
-            // Set calo hit to MCParticle relation using trackID
-            if (parameters.m_dataFormat == Parameters::LArNDFormat::SPMC)
+            if (isCoarsened)
+                std::cout << "COARSENED EVENT: merged " << nSP << " space points into " << coarseX.size() << " using cell width "
+                          << eventVoxelWidth << " cm" << std::endl;
+
+            // The space points of a sub-event are gathered, unless they are merged into coarser cells
+            std::vector<float> windowX, windowY, windowZ, windowCharge;
+
+            if (isSubEvent && !isCoarsened)
             {
-                LArSPMC *larspmc = dynamic_cast<LArSPMC *>(larsp.get());
-                const std::vector<float> mcContribs = (*larspmc->m_hit_packetFrac)[isp];
-                const int biggestContribIndex = std::distance(mcContribs.begin(), std::max_element(mcContribs.begin(), mcContribs.end()));
-                const std::vector<long> hitPartIDVect = (*larspmc->m_hit_particleID)[isp];
-                trackID = (hitPartIDVect.size() > biggestContribIndex) ? hitPartIDVect[biggestContribIndex] : 0;
-
-                // Due to the merging of hits, the contributions can sometimes add up to more than 1.
-                // Normalise first
-                const float sum = std::accumulate(mcContribs.begin(), mcContribs.end(), 0.f);
-                energyFrac = (biggestContribIndex < mcContribs.size() && std::abs(sum) > 0.0) ? mcContribs[biggestContribIndex] / sum : 0.f;
-                // Make sure the energy fraction is not larger than 1
-                if (energyFrac > 1.f + std::numeric_limits<float>::epsilon())
-                    energyFrac = 1.f;
-
-                if (std::find(larspmc->m_mcp_id->begin(), larspmc->m_mcp_id->end(), trackID) == larspmc->m_mcp_id->end())
-                    std::cout << "Problem? Could not find MC particle with file ID " << trackID << std::endl;
+                for (const size_t isp : windowSPs)
+                {
+                    windowX.emplace_back((*larsp->m_x)[isp]);
+                    windowY.emplace_back((*larsp->m_y)[isp]);
+                    windowZ.emplace_back((*larsp->m_z)[isp]);
+                    windowCharge.emplace_back((*larsp->m_charge)[isp]);
+                }
             }
 
-            if (parameters.m_use3D)
-                PANDORA_THROW_RESULT_IF(
-                    pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::CaloHit::Create(*pPrimaryPandora, caloHitParameters, m_larCaloHitFactory));
+            const std::vector<float> &spX(isCoarsened ? coarseX : isSubEvent ? windowX : *larsp->m_x);
+            const std::vector<float> &spY(isCoarsened ? coarseY : isSubEvent ? windowY : *larsp->m_y);
+            const std::vector<float> &spZ(isCoarsened ? coarseZ : isSubEvent ? windowZ : *larsp->m_z);
+            const std::vector<float> &spCharge(isCoarsened ? coarseCharge : isSubEvent ? windowCharge : *larsp->m_charge);
 
+            // Some truth information first
             if (parameters.m_dataFormat == Parameters::LArNDFormat::SPMC)
-                PandoraApi::SetCaloHitToMCParticleRelationship(*pPrimaryPandora, (void *)((intptr_t)hitCounter), (void *)((intptr_t)trackID), energyFrac);
+            {
+                LArSPMC *larspmc = dynamic_cast<LArSPMC *>(larsp.get());
+                CreateSPMCParticles(*larspmc, pPrimaryPandora, parameters);
+            }
+
+            int hitCounter(0);
+            lar_content::LArEventHitVolumes::Get().Clear();
+            lar_content::LArEventHitVoxels::Get().Clear();
 
+            // Find the wire coordinates of all space points in one go
             if (parameters.m_useLArTPC)
+                wireProjection.Project(spY, spZ, uPositions, vPositions, wPositions);
+
+            // Quantised 2D projections that are merged before making their caloHits, if required
+            const float projectionWidth(parameters.m_spProjectionMergeWidth);
+            const bool shouldMergeProjections(parameters.m_useLArTPC && projectionWidth > 0.f);
+            LArVoxelProjectionList projections;
+
+            // Loop over the space points and make them into caloHits
+            for (size_t ihit = 0; ihit < spX.size(); ++ihit)
             {
-                // Create LArCaloHits for U, V and W views assuming x is the common drift coordinate
-                const float x0_cm(voxelPos.GetX());
-                const float y0_cm(voxelPos.GetY());
-                const float z0_cm(voxelPos.GetZ());
-
-                // U view
-                lar_content::LArCaloHitParameters caloHitPars_UView(caloHitParameters);
-                caloHitPars_UView.m_hitType = pandora::TPC_VIEW_U;
-                caloHitPars_UView.m_pParentAddress = (void *)(intptr_t(++hitCounter));
-                const float upos_cm(pPrimaryPandora->GetPlugins()->GetLArTransformationPlugin()->YZtoU(y0_cm, z0_cm));
-                caloHitPars_UView.m_positionVector = pandora::CartesianVector(x0_cm, 0.f, upos_cm);
-
-                PANDORA_THROW_RESULT_IF(
-                    pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::CaloHit::Create(*pPrimaryPandora, caloHitPars_UView, m_larCaloHitFactory));
-                if (parameters.m_dataFormat == Parameters::LArNDFormat::SPMC)
-                    PandoraApi::SetCaloHitToMCParticleRelationship(
-                        *pPrimaryPandora, (void *)((intptr_t)hitCounter), (void *)((intptr_t)trackID), energyFrac);
+                // Index of the input space point, used for the truth
+                const size_t isp(isCoarsened ? spIndices[ihit] : isSubEvent ? windowSPs[ihit] : ihit);
+                const float voxelX = spX[ihit];
+                const float voxelY = spY[ihit];
+                const float voxelZ = spZ[ihit];
+                const float voxelE = spCharge[ihit];
+
+                // Skip this hit if its coordinates or energy are NaNs
+                if (std::isnan(voxelX) || std::isnan(voxelY) || std::isnan(voxelZ) || std::isnan(voxelE))
+                {
+                    std::cout << "Ignoring hit " << ihit << " which contains NaNs: (" << voxelX << ", " << voxelY << ", " << voxelZ
+                              << "), E = " << voxelE << std::endl;
+                    continue;
+                }
 
-                // V view
-                lar_content::LArCaloHitParameters caloHitPars_VView(caloHitParameters);
-                caloHitPars_VView.m_hitType = pandora::TPC_VIEW_V;
-                caloHitPars_VView.m_pParentAddress = (void *)(intptr_t(++hitCounter));
-                const float vpos_cm(pPrimaryPandora->GetPlugins()->GetLArTransformationPlugin()->YZtoV(y0_cm, z0_cm));
-                caloHitPars_VView.m_positionVector = pandora::CartesianVector(x0_cm, 0.f, vpos_cm);
-                PANDORA_THROW_RESULT_IF(
-                    pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::CaloHit::Create(*pPrimaryPandora, caloHitPars_VView, m_larCaloHitFactory));
+                const pandora::CartesianVector voxelPos(voxelX, voxelY, voxelZ);
+                const float MipE{0.00075};
+                const float voxelMipEquivalentE = voxelE / MipE;
+                const int tpcID(geom.GetTPCNumber(voxelPos));
+                lar_content::LArCaloHitParameters caloHitParameters;
+                caloHitParameters.m_positionVector = voxelPos;
+                caloHitParameters.m_expectedDirection = pandora::CartesianVector(0.f, 0.f, 1.f);
+                caloHitParameters.m_cellNormalVector = pandora::CartesianVector(0.f, 0.f, 1.f);
+                caloHitParameters.m_cellGeometry = pandora::RECTANGULAR;
+                caloHitParameters.m_cellSize0 = eventVoxelWidth;
+                caloHitParameters.m_cellSize1 = eventVoxelWidth;
+                caloHitParameters.m_cellThickness = eventVoxelWidth;
+                caloHitParameters.m_nCellRadiationLengths = 1.f;
+                caloHitParameters.m_nCellInteractionLengths = 1.f;
+                caloHitParameters.m_time = 0.f;
+                caloHitParameters.m_inputEnergy = voxelE;
+                caloHitParameters.m_mipEquivalentEnergy = voxelMipEquivalentE;
+                caloHitParameters.m_electromagneticEnergy = voxelE;
+                caloHitParameters.m_hadronicEnergy = voxelE;
+                caloHitParameters.m_isDigital = false;
+                caloHitParameters.m_hitType = pandora::TPC_3D;
+                caloHitParameters.m_hitRegion = pandora::SINGLE_REGION;
+                caloHitParameters.m_layer = 0;
+                caloHitParameters.m_isInOuterSamplingLayer = false;
+                caloHitParameters.m_pParentAddress = (void *)(static_cast<uintptr_t>(++hitCounter));
+                caloHitParameters.m_larTPCVolumeId = tpcID < 0 ? 0 : tpcID;
+                caloHitParameters.m_daughterVolumeId = 0;
+
+                // Only used for truth
+                long trackID{0};
+                float energyFrac{0.f};
+                LArMCContributions mcContributions;
+                // Set calo hit to MCParticle relation using trackID
                 if (parameters.m_dataFormat == Parameters::LArNDFormat::SPMC)
-                    PandoraApi::SetCaloHitToMCParticleRelationship(
-                        *pPrimaryPandora, (void *)((intptr_t)hitCounter), (void *)((intptr_t)trackID), energyFrac);
-                // W view
-                lar_content::LArCaloHitParameters caloHitPars_WView(caloHitParameters);
-                caloHitPars_WView.m_hitType = pandora::TPC_VIEW_W;
-                caloHitPars_WView.m_pParentAddress = (void *)(intptr_t(++hitCounter));
-                const float wpos_cm(pPrimaryPandora->GetPlugins()->GetLArTransformationPlugin()->YZtoW(y0_cm, z0_cm));
-                caloHitPars_WView.m_positionVector = pandora::CartesianVector(x0_cm, 0.f, wpos_cm);
-
-                PANDORA_THROW_RESULT_IF(
-                    pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::CaloHit::Create(*pPrimaryPandora, caloHitPars_WView, m_larCaloHitFactory));
+                {
+                    LArSPMC *larspmc = dynamic_cast<LArSPMC *>(larsp.get());
+                    const std::vector<float> mcContribs = (*larspmc->m_hit_packetFrac)[isp];
+                    const int biggestContribIndex =
+                        std::distance(mcContribs.begin(), std::max_element(mcContribs.begin(), mcContribs.end()));
+                    const std::vector<long> hitPartIDVect = (*larspmc->m_hit_particleID)[isp];
+                    trackID = (hitPartIDVect.size() > biggestContribIndex) ? hitPartIDVect[biggestContribIndex] : 0;
+
+                    // Due to the merging of hits, the contributions can sometimes add up to more than 1.
+                    // Normalise first
+                    const float sum = std::accumulate(mcContribs.begin(), mcContribs.end(), 0.f);
+                    energyFrac =
+                        (biggestContribIndex < mcContribs.size() && std::abs(sum) > 0.0) ? mcContribs[biggestContribIndex] / sum : 0.f;
+                    // Make sure the energy fraction is not larger than 1
+                    if (energyFrac > 1.f + std::numeric_limits<float>::epsilon())
+                        energyFrac = 1.f;
+
+                    if (std::find(larspmc->m_mcp_id->begin(), larspmc->m_mcp_id->end(), trackID) == larspmc->m_mcp_id->end())
+                        std::cout << "Problem? Could not find MC particle with file ID " << trackID << std::endl;
+
+                    // Energy contributions of all particles, for merged projections
+                    if (shouldMergeProjections && std::abs(sum) > 0.0)
+                    {
+                        for (size_t imc = 0; imc < mcContribs.size() && imc < hitPartIDVect.size(); ++imc)
+                            mcContributions.Add(hitPartIDVect[imc], voxelE * mcContribs[imc] / sum);
+                    }
+                }
+
+                if (parameters.m_use3D)
+                    CreateLArCaloHit(pPrimaryPandora, caloHitParameters, m_larCaloHitFactory);
+
                 if (parameters.m_dataFormat == Parameters::LArNDFormat::SPMC)
                     PandoraApi::SetCaloHitToMCParticleRelationship(
                         *pPrimaryPandora, (void *)((intptr_t)hitCounter), (void *)((intptr_t)trackID), energyFrac);
-            }
 
-        } // end space point loop
+                if (shouldMergeProjections)
+                {
+                    // Keep the quantised U, V and W projections, assuming x is the common drift coordinate
+                    const unsigned int tpcVolumeID(caloHitParameters.m_larTPCVolumeId);
+                    const float drift(QuantiseProjection(voxelX, projectionWidth));
+                    projections.emplace_back(LArVoxelProjection(voxelE, QuantiseProjection(uPositions[ihit], projectionWidth), drift,
+                        pandora::TPC_VIEW_U, isp, mcContributions, tpcVolumeID));
+                    projections.emplace_back(LArVoxelProjection(voxelE, QuantiseProjection(vPositions[ihit], projectionWidth), drift,
+                        pandora::TPC_VIEW_V, isp, mcContributions, tpcVolumeID));
+                    projections.emplace_back(LArVoxelProjection(voxelE, QuantiseProjection(wPositions[ihit], projectionWidth), drift,
+                        pandora::TPC_VIEW_W, isp, mcContributions, tpcVolumeID));
+                }
+                else if (parameters.m_useLArTPC)
+                {
+                    // Create LArCaloHits for U, V and W views assuming x is the common drift coordinate
+                    const float x0_cm(voxelPos.GetX());
+
+                    // U view
+                    lar_content::LArCaloHitParameters caloHitPars_UView(caloHitParameters);
+                    caloHitPars_UView.m_hitType = pandora::TPC_VIEW_U;
+                    caloHitPars_UView.m_pParentAddress = (void *)(intptr_t(++hitCounter));
+                    const float upos_cm(uPositions[ihit]);
+                    caloHitPars_UView.m_positionVector = pandora::CartesianVector(x0_cm, 0.f, upos_cm);
+
+                    CreateLArCaloHit(pPrimaryPandora, caloHitPars_UView, m_larCaloHitFactory);
+                    if (parameters.m_dataFormat == Parameters::LArNDFormat::SPMC)
+                        PandoraApi::SetCaloHitToMCParticleRelationship(
+                            *pPrimaryPandora, (void *)((intptr_t)hitCounter), (void *)((intptr_t)trackID), energyFrac);
+
+                    // V view
+                    lar_content::LArCaloHitParameters caloHitPars_VView(caloHitParameters);
+                    caloHitPars_VView.m_hitType = pandora::TPC_VIEW_V;
+                    caloHitPars_VView.m_pParentAddress = (void *)(intptr_t(++hitCounter));
+                    const float vpos_cm(vPositions[ihit]);
+                    caloHitPars_VView.m_positionVector = pandora::CartesianVector(x0_cm, 0.f, vpos_cm);
+                    CreateLArCaloHit(pPrimaryPandora, caloHitPars_VView, m_larCaloHitFactory);
+                    if (parameters.m_dataFormat == Parameters::LArNDFormat::SPMC)
+                        PandoraApi::SetCaloHitToMCParticleRelationship(
+                            *pPrimaryPandora, (void *)((intptr_t)hitCounter), (void *)((intptr_t)trackID), energyFrac);
+                    // W view
+                    lar_content::LArCaloHitParameters caloHitPars_WView(caloHitParameters);
+                    caloHitPars_WView.m_hitType = pandora::TPC_VIEW_W;
+                    caloHitPars_WView.m_pParentAddress = (void *)(intptr_t(++hitCounter));
+                    const float wpos_cm(wPositions[ihit]);
+                    caloHitPars_WView.m_positionVector = pandora::CartesianVector(x0_cm, 0.f, wpos_cm);
+
+                    CreateLArCaloHit(pPrimaryPandora, caloHitPars_WView, m_larCaloHitFactory);
+                    if (parameters.m_dataFormat == Parameters::LArNDFormat::SPMC)
+                        PandoraApi::SetCaloHitToMCParticleRelationship(
+                            *pPrimaryPandora, (void *)((intptr_t)hitCounter), (void *)((intptr_t)trackID), energyFrac);
+                }
+
+            } // end space point loop
 
-        PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::ProcessEvent(*pPrimaryPandora));
-        PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::Reset(*pPrimaryPandora));
+            if (shouldMergeProjections)
+                MakeCaloHitsFromSpacePointProjections(projections, pPrimaryPandora, parameters, eventVoxelWidth, hitCounter);
+
+            if (isSubEvent)
+            {
+                const LArTimeWindow &timeWindow(timeWindows[iSubEvent]);
+                std::cout << "SUB-EVENT " << iSubEvent << " of " << nSubEvents << ": " << timeWindow.m_spIndices.size()
+                          << " space points with times " << timeWindow.m_startTime << " to " << timeWindow.m_endTime << std::endl;
+                lar_content::LArSubEvent::Get().Set(iSubEvent, timeWindow.m_startTime, timeWindow.m_endTime, isNewSpill);
+            }
+
+            ProcessPrimaryEvent(pPrimaryPandora, hitCounter);
+            isNewSpill = false;
+        } // end sub-event loop
     } // end event loop
 
     fileSource->Close();
@@ -497,7 +1131,7 @@ void ProcessSPEvents(const Parameters &parameters, const Pandora *const pPrimary
 
 void CreateSPMCParticles(const LArSPMC &larspmc, const pandora::Pandora *const pPrimaryPandora, const Parameters &parameters)
 {
-    lar_content::LArMCParticleFactory mcParticleFactory;
+    lar_content::LArPooledMCParticleFactory mcParticleFactory;
 
     const int nNeutrinos(larspmc.m_nuPDG->size());
     std::cout << "Read in " << nNeutrinos << " true neutrinos" << std::endl;
@@ -580,50 +1214,289 @@ void CreateSPMCParticles(const LArSPMC &larspmc, const pandora::Pandora *const p
         const std::string reaction = GetNuanceReaction((*larspmc.m_ccnc)[nuIndex], (*larspmc.m_mode)[nuIndex]);
         mcParticleParameters.m_nuanceCode = GetNuanceCode(reaction);
 
-        // Unique file-based ID for this MC particle
-        const long mcpID = (*larspmc.m_mcp_id)[i];
-        mcParticleParameters.m_pParentAddress = (void *)((intptr_t)mcpID);
+        // Unique file-based ID for this MC particle
+        const long mcpID = (*larspmc.m_mcp_id)[i];
+        mcParticleParameters.m_pParentAddress = (void *)((intptr_t)mcpID);
+
+        // Start and end points in cm
+        const float startx = (*larspmc.m_mcp_startx)[i] * parameters.m_lengthScale;
+        const float starty = (*larspmc.m_mcp_starty)[i] * parameters.m_lengthScale;
+        const float startz = (*larspmc.m_mcp_startz)[i] * parameters.m_lengthScale;
+        mcParticleParameters.m_vertex = pandora::CartesianVector(startx, starty, startz);
+
+        const float endx = (*larspmc.m_mcp_endx)[i] * parameters.m_lengthScale;
+        const float endy = (*larspmc.m_mcp_endy)[i] * parameters.m_lengthScale;
+        const float endz = (*larspmc.m_mcp_endz)[i] * parameters.m_lengthScale;
+        mcParticleParameters.m_endpoint = pandora::CartesianVector(endx, endy, endz);
+
+        // Process ID
+        mcParticleParameters.m_process = lar_content::MC_PROC_UNKNOWN;
+
+        // Create MCParticle
+        try
+        {
+            PANDORA_THROW_RESULT_IF(
+                pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::MCParticle::Create(*pPrimaryPandora, mcParticleParameters, mcParticleFactory));
+        }
+        catch (const pandora::StatusCodeException &)
+        {
+            std::cout << "Unable to create MCParticle " << i << " : invalid info supplied, e.g. non-unique trackID or NaNs" << std::endl;
+            continue;
+        }
+
+        // Set parent relationship. For the parent, use its <vertex_id, mcp_idLocal> pair to get its unique ID
+        const long mcpMotherID = (*larspmc.m_mcp_mother)[i];
+        const std::pair<long, long> parentPair = std::make_pair(mcpVertexID, mcpMotherID);
+        const long mcpParentID = (mcIDMap.find(parentPair) != mcIDMap.end()) ? mcIDMap.at(parentPair) : mcpMotherID;
+
+        if (mcpParentID == -1) // link to mc neutrino
+        {
+            PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=,
+                PandoraApi::SetMCParentDaughterRelationship(*pPrimaryPandora, (void *)((intptr_t)mcpVertexID), (void *)((intptr_t)mcpID)));
+        }
+        else
+        {
+            PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=,
+                PandoraApi::SetMCParentDaughterRelationship(*pPrimaryPandora, (void *)((intptr_t)mcpParentID), (void *)((intptr_t)mcpID)));
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void MakeSpacePointTimeWindows(const LArSP &larsp, const Parameters &parameters, LArTimeWindowList &timeWindows)
+{
+    timeWindows.clear();
+
+    if (parameters.m_subEventTimeGap <= 0.f)
+        return;
+
+    const size_t nSP(larsp.m_x->size());
+
+    if (!larsp.m_ts || (larsp.m_ts->size() != nSP))
+    {
+        std::cout << "Not splitting the spill into sub-events, as the input has no space point times" << std::endl;
+        return;
+    }
+
+    // Order the space points in time, with any NaN times last
+    const std::vector<float> &times(*larsp.m_ts);
+    std::vector<size_t> timeOrder(nSP);
+    std::iota(timeOrder.begin(), timeOrder.end(), 0);
+    std::stable_sort(timeOrder.begin(), timeOrder.end(), [&times](const size_t lhs, const size_t rhs)
+        { return (times[lhs] < times[rhs]) || (!std::isnan(times[lhs]) && std::isnan(times[rhs])); });
+
+    // The [first, end) ranges of the time ordered space points between the gaps, which a NaN time never starts
+    std::vector<std::pair<size_t, size_t>> ranges;
+
+    for (size_t iOrder = 0; iOrder < nSP; ++iOrder)
+    {
+        if ((0 == iOrder) || (times[timeOrder[iOrder]] - times[timeOrder[iOrder - 1]] >= parameters.m_subEventTimeGap))
+            ranges.emplace_back(iOrder, iOrder + 1);
+        else
+            ranges.back().second = iOrder + 1;
+    }
+
+    // Merge the smallest window into its nearest neighbour in time, until all windows are populated enough
+    while (ranges.size() > 1)
+    {
+        const auto smallestIter(std::min_element(ranges.begin(), ranges.end(),
+            [](const std::pair<size_t, size_t> &lhs, const std::pair<size_t, size_t> &rhs)
+            { return (lhs.second - lhs.first) < (rhs.second - rhs.first); }));
+
+        if (smallestIter->second - smallestIter->first >= static_cast<size_t>(parameters.m_minSubEventSPs))
+            break;
+
+        const size_t iRange(std::distance(ranges.begin(), smallestIter));
+        const float startTime(times[timeOrder[smallestIter->first]]), endTime(times[timeOrder[smallestIter->second - 1]]);
+        const float previousGap(iRange > 0 ? startTime - times[timeOrder[ranges[iRange - 1].second - 1]] : 0.f);
+        const float nextGap(iRange + 1 < ranges.size() ? times[timeOrder[ranges[iRange + 1].first]] - endTime : 0.f);
+        const size_t iMerged((0 == iRange) || ((iRange + 1 < ranges.size()) && (nextGap < previousGap)) ? iRange + 1 : iRange - 1);
+
+        ranges[iMerged].first = std::min(ranges[iMerged].first, smallestIter->first);
+        ranges[iMerged].second = std::max(ranges[iMerged].second, smallestIter->second);
+        ranges.erase(smallestIter);
+    }
+
+    for (const std::pair<size_t, size_t> &range : ranges)
+    {
+        LArTimeWindow timeWindow;
+        timeWindow.m_spIndices.assign(timeOrder.begin() + range.first, timeOrder.begin() + range.second);
+        std::sort(timeWindow.m_spIndices.begin(), timeWindow.m_spIndices.end());
+
+        // The window ends at its latest valid time
+        size_t iEnd(range.second - 1);
+        while ((iEnd > range.first) && std::isnan(times[timeOrder[iEnd]]))
+            --iEnd;
+
+        timeWindow.m_startTime = times[timeOrder[range.first]];
+        timeWindow.m_endTime = times[timeOrder[iEnd]];
+        timeWindows.push_back(std::move(timeWindow));
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool CoarsenSpacePoints(const LArSP &larsp, const std::vector<size_t> &inputIndices, const Parameters &parameters,
+    std::vector<size_t> &spIndices, std::vector<float> &xVect, std::vector<float> &yVect, std::vector<float> &zVect,
+    std::vector<float> &chargeVect, float &cellWidth)
+{
+    const size_t nSP(inputIndices.empty() ? larsp.m_x->size() : inputIndices.size());
+    cellWidth = parameters.m_voxelWidth;
+
+    for (int iStep = 1; iStep <= parameters.m_maxVoxelCoarsening; ++iStep)
+    {
+        cellWidth *= 2.f;
+        spIndices.clear();
+        xVect.clear();
+        yVect.clear();
+        zVect.clear();
+        chargeVect.clear();
+
+        // Summed charge-weighted positions and the largest input charge for each cell
+        std::map<LongBin3Array, size_t> cellToIndex;
+        std::vector<float> sumX, sumY, sumZ, maxCharge;
+        std::vector<int> nInCell;
+
+        for (size_t iInput = 0; iInput < nSP; ++iInput)
+        {
+            const size_t isp(inputIndices.empty() ? iInput : inputIndices[iInput]);
+            const float x((*larsp.m_x)[isp]);
+            const float y((*larsp.m_y)[isp]);
+            const float z((*larsp.m_z)[isp]);
+            const float charge((*larsp.m_charge)[isp]);
+
+            // NaN space points would be ignored anyway
+            if (std::isnan(x) || std::isnan(y) || std::isnan(z) || std::isnan(charge))
+                continue;
+
+            const LongBin3Array cell = {static_cast<long>(std::floor(x / cellWidth)), static_cast<long>(std::floor(y / cellWidth)),
+                static_cast<long>(std::floor(z / cellWidth))};
+            const auto iter = cellToIndex.find(cell);
+            if (iter == cellToIndex.end())
+            {
+                cellToIndex.emplace(cell, spIndices.size());
+                spIndices.emplace_back(isp);
+                xVect.emplace_back(x);
+                yVect.emplace_back(y);
+                zVect.emplace_back(z);
+                chargeVect.emplace_back(charge);
+                sumX.emplace_back(charge * x);
+                sumY.emplace_back(charge * y);
+                sumZ.emplace_back(charge * z);
+                maxCharge.emplace_back(charge);
+                nInCell.emplace_back(1);
+                continue;
+            }
+
+            const size_t index(iter->second);
+            xVect[index] += x;
+            yVect[index] += y;
+            zVect[index] += z;
+            chargeVect[index] += charge;
+            sumX[index] += charge * x;
+            sumY[index] += charge * y;
+            sumZ[index] += charge * z;
+            ++nInCell[index];
+
+            if (charge > maxCharge[index])
+            {
+                maxCharge[index] = charge;
+                spIndices[index] = isp;
+            }
+        }
+
+        // Use the charge-weighted mean position, or the plain mean if the cell has no net charge
+        for (size_t index = 0; index < chargeVect.size(); ++index)
+        {
+            if (chargeVect[index] > 0.f)
+            {
+                xVect[index] = sumX[index] / chargeVect[index];
+                yVect[index] = sumY[index] / chargeVect[index];
+                zVect[index] = sumZ[index] / chargeVect[index];
+            }
+            else
+            {
+                xVect[index] /= nInCell[index];
+                yVect[index] /= nInCell[index];
+                zVect[index] /= nInCell[index];
+            }
+        }
+
+        if (chargeVect.size() <= static_cast<size_t>(parameters.m_maxMergedVoxels))
+            return true;
+    }
+
+    return false;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+float QuantiseProjection(const float position, const float width)
+{
+    return (std::floor(position / width) + 0.5f) * width;
+}
 
-        // Start and end points in cm
-        const float startx = (*larspmc.m_mcp_startx)[i] * parameters.m_lengthScale;
-        const float starty = (*larspmc.m_mcp_starty)[i] * parameters.m_lengthScale;
-        const float startz = (*larspmc.m_mcp_startz)[i] * parameters.m_lengthScale;
-        mcParticleParameters.m_vertex = pandora::CartesianVector(startx, starty, startz);
+//------------------------------------------------------------------------------------------------------------------------------------------
 
-        const float endx = (*larspmc.m_mcp_endx)[i] * parameters.m_lengthScale;
-        const float endy = (*larspmc.m_mcp_endy)[i] * parameters.m_lengthScale;
-        const float endz = (*larspmc.m_mcp_endz)[i] * parameters.m_lengthScale;
-        mcParticleParameters.m_endpoint = pandora::CartesianVector(endx, endy, endz);
+void MakeCaloHitsFromSpacePointProjections(const LArVoxelProjectionList &projections, const pandora::Pandora *const pPrimaryPandora,
+    const Parameters &parameters, const float cellWidth, int &hitCounter)
+{
+    // Factory for creating LArCaloHits
+    lar_content::LArPooledCaloHitFactory m_larCaloHitFactory;
+    const float MipE{0.00075};
+    // The merged 2D hits span the whole quantisation cell, which can be wider than the space point cells
+    const float hitWidth(std::max(cellWidth, parameters.m_spProjectionMergeWidth));
+    lar_content::LArCaloHitParameters caloHitParameters = MakeDefaultCaloHitParams(hitWidth);
+
+    LArVoxelProjectionList voxelProjectionsU;
+    LArVoxelProjectionList voxelProjectionsV;
+    LArVoxelProjectionList voxelProjectionsW;
+
+    for (const LArVoxelProjection &projection : projections)
+    {
+        if (projection.m_view == pandora::TPC_VIEW_U)
+            voxelProjectionsU.emplace_back(projection);
+        else if (projection.m_view == pandora::TPC_VIEW_V)
+            voxelProjectionsV.emplace_back(projection);
+        else
+            voxelProjectionsW.emplace_back(projection);
+    }
 
-        // Process ID
-        mcParticleParameters.m_process = lar_content::MC_PROC_UNKNOWN;
+    // Merge projections that have the same quantised wire and drift positions in each view, keeping the TPCs apart, since space
+    // points of different modules in the same x column often share a U or V cell
+    std::vector<LArVoxelProjectionList> viewProjections;
+    viewProjections.emplace_back(MergeSameProjections(voxelProjectionsU, false));
+    viewProjections.emplace_back(MergeSameProjections(voxelProjectionsV, false));
+    viewProjections.emplace_back(MergeSameProjections(voxelProjectionsW, false));
 
-        // Create MCParticle
-        try
-        {
-            PANDORA_THROW_RESULT_IF(
-                pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::MCParticle::Create(*pPrimaryPandora, mcParticleParameters, mcParticleFactory));
-        }
-        catch (const pandora::StatusCodeException &)
+    for (const LArVoxelProjectionList &view : viewProjections)
+    {
+        for (const LArVoxelProjection &hit : view)
         {
-            std::cout << "Unable to create MCParticle " << i << " : invalid info supplied, e.g. non-unique trackID or NaNs" << std::endl;
-            continue;
-        }
+            caloHitParameters.m_positionVector = pandora::CartesianVector(hit.m_drift, 0.f, hit.m_wire);
+            caloHitParameters.m_inputEnergy = hit.m_energy;
+            caloHitParameters.m_mipEquivalentEnergy = hit.m_energy / MipE;
+            caloHitParameters.m_electromagneticEnergy = hit.m_energy;
+            caloHitParameters.m_hadronicEnergy = hit.m_energy;
+            caloHitParameters.m_pParentAddress = (void *)(static_cast<uintptr_t>(++hitCounter));
+            caloHitParameters.m_hitType = hit.m_view;
+            caloHitParameters.m_larTPCVolumeId = hit.m_tpcID;
 
-        // Set parent relationship. For the parent, use its <vertex_id, mcp_idLocal> pair to get its unique ID
-        const long mcpMotherID = (*larspmc.m_mcp_mother)[i];
-        const std::pair<long, long> parentPair = std::make_pair(mcpVertexID, mcpMotherID);
-        const long mcpParentID = (mcIDMap.find(parentPair) != mcIDMap.end()) ? mcIDMap.at(parentPair) : mcpMotherID;
+            CreateLArCaloHit(pPrimaryPandora, caloHitParameters, m_larCaloHitFactory);
 
-        if (mcpParentID == -1) // link to mc neutrino
-        {
-            PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=,
-                PandoraApi::SetMCParentDaughterRelationship(*pPrimaryPandora, (void *)((intptr_t)mcpVertexID), (void *)((intptr_t)mcpID)));
-        }
-        else
-        {
-            PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=,
-                PandoraApi::SetMCParentDaughterRelationship(*pPrimaryPandora, (void *)((intptr_t)mcpParentID), (void *)((intptr_t)mcpID)));
+            if (parameters.m_dataFormat != Parameters::LArNDFormat::SPMC)
+                continue;
+
+            // Set the relation to each contributing MCParticle, weighted by its fraction of the merged hit energy
+            for (unsigned int i = 0; i < hit.m_mcContributions.m_nContributors; ++i)
+            {
+                const long trackID = hit.m_mcContributions.m_trackIDs[i];
+                const float energyFrac =
+                    std::abs(hit.m_energy) > 0.f ? std::min(1.f, hit.m_mcContributions.m_energies[i] / hit.m_energy) : 0.f;
+                PandoraApi::SetCaloHitToMCParticleRelationship(
+                    *pPrimaryPandora, (void *)((intptr_t)hitCounter), (void *)((intptr_t)trackID), energyFrac);
+            }
         }
     }
 }
@@ -653,10 +1526,13 @@ void ProcessEDepSimEvents(const Parameters &parameters, const Pandora *const pPr
     pEDepSimTree->SetBranchAddress("Event", &pEDepSimEvent);
 
     // Factory for creating LArCaloHits
-    lar_content::LArCaloHitFactory m_larCaloHitFactory;
+    lar_content::LArPooledCaloHitFactory m_larCaloHitFactory;
 
     const LArGrid grid = parameters.m_useModularGeometry ? MakeVoxelisationGrid(geom, parameters) : MakeVoxelisationGrid(pPrimaryPandora, parameters);
 
+    // Lookup tables for projecting the voxel grid lattice onto the wire coordinates
+    const LArWireProjection wireProjection(pPrimaryPandora->GetPlugins()->GetLArTransformationPlugin(), grid);
+
     std::cout << "Total grid volume: bot = " << grid.m_bottom << "\n top = " << grid.m_top << std::endl;
     std::cout << "Making voxels with size " << grid.m_binWidths << std::endl;
 
@@ -672,20 +1548,27 @@ void ProcessEDepSimEvents(const Parameters &parameters, const Pandora *const pPr
 
     std::cout << "Start event is " << startEvt << " and end event is " << endEvt - 1 << std::endl;
 
-    for (int iEvt = startEvt; iEvt < endEvt; iEvt++)
+    // The events of this process, if they are shared between child processes
+    int firstEvt(startEvt), lastEvt(endEvt), eventStride(1);
+    GetProcessEventRange(parameters, startEvt, endEvt, firstEvt, lastEvt, eventStride);
+
+    for (int iEvt = firstEvt; iEvt < lastEvt; iEvt += eventStride)
     {
         if (parameters.m_shouldDisplayEventNumber)
             std::cout << std::endl << "   PROCESSING EVENT: " << iEvt << std::endl << std::endl;
 
         pEDepSimTree->GetEntry(iEvt);
 
+        // Used to key the event records on the input entry
+        lar_content::LArProcessShard::Get().m_eventEntry = iEvt - startEvt;
+
         if (!pEDepSimEvent)
             return;
 
         // Create MCParticles from Geant4 trajectories
         const MCParticleEnergyMap MCEnergyMap = CreateEDepSimMCParticles(*pEDepSimEvent, pPrimaryPandora, parameters);
 
-        int hitCounter{0};
+        LArHitInfoList hitInfoList;
 
         // Loop over (EDep) hits, which are stored in the hit segment detectors.
         // Only process hits from the detector we are interested in
@@ -701,9 +1584,7 @@ void ProcessEDepSimEvents(const Parameters &parameters, const Pandora *const pPr
             std::cout << "Show hits for " << detector->first << " (" << detector->second.size() << " hits)" << std::endl;
             std::cout << "                                 " << std::endl;
 
-            LArVoxelList voxelList;
-
-            // Loop over hit segments and create voxels from them
+            // Loop over hit segments, which are all voxelised together, so that the event has a single voxel width
             for (TG4HitSegment &g4Hit : detector->second)
             {
                 const TLorentzVector &hitStart = g4Hit.GetStart();
@@ -713,33 +1594,43 @@ void ProcessEDepSimEvents(const Parameters &parameters, const Pandora *const pPr
                 const float energy = g4Hit.GetEnergyDeposit();
                 const int g4id = g4Hit.GetContributors()[0];
 
-                const LArHitInfo hitInfo(start, end, energy, g4id, parameters.m_lengthScale, parameters.m_energyScale);
-                const LArVoxelList currentVoxelList = MakeVoxels(hitInfo, grid, parameters, geom);
-
-                for (const LArVoxel &voxel : currentVoxelList)
-                    voxelList.emplace_back(voxel);
+                hitInfoList.emplace_back(start, end, energy, g4id, parameters.m_lengthScale, parameters.m_energyScale);
             }
+        } // end segment detector loop
 
-            std::cout << "Produced " << voxelList.size() << " voxels from " << detector->second.size() << " hit segments." << std::endl;
+        LArVoxelList voxelList = MakeVoxels(hitInfoList, grid, parameters, geom);
 
-            // Merge voxels with the same IDs
-            const LArVoxelList mergedVoxels = MergeSameVoxels(voxelList);
+        std::cout << "Produced " << voxelList.size() << " voxels from " << hitInfoList.size() << " hit segments." << std::endl;
 
-            std::cout << "Produced " << mergedVoxels.size() << " merged voxels from " << voxelList.size() << " voxels." << std::endl;
-            voxelList.clear();
+        // Merge voxels with the same IDs
+        LArVoxelList mergedVoxels = MergeSameVoxels(voxelList);
 
-            // Stop processing the event if we have too many voxels: reco takes too long
-            if (parameters.m_maxMergedVoxels > 0 && mergedVoxels.size() > parameters.m_maxMergedVoxels)
-            {
-                std::cout << "SKIPPING EVENT: number of merged voxels " << mergedVoxels.size() << " > " << parameters.m_maxMergedVoxels << std::endl;
-                break;
-            }
+        // Represent straight runs of voxels by their end voxels, which keep the IDs of the voxels they represent through any sorting
+        if (parameters.m_maxCollinearRun > 0)
+            mergedVoxels = CompressCollinearVoxels(mergedVoxels, grid, parameters);
 
-            MakeCaloHitsFromVoxels(mergedVoxels, MCEnergyMap, pPrimaryPandora, parameters, hitCounter);
-        } // end segment detector loop
+        if (parameters.m_useMortonVoxelOrder)
+            SortVoxelsByID(mergedVoxels);
+
+        std::cout << "Produced " << mergedVoxels.size() << " merged voxels from " << voxelList.size() << " voxels." << std::endl;
+        voxelList.clear();
+
+        // If we have too many voxels, reco takes too long: re-bin them with larger voxels if allowed, otherwise skip the event
+        Parameters eventParameters(parameters);
+        if (parameters.m_maxMergedVoxels > 0 && mergedVoxels.size() > parameters.m_maxMergedVoxels &&
+            !CoarsenEventVoxels(grid, parameters, mergedVoxels, eventParameters.m_voxelWidth))
+        {
+            std::cout << "SKIPPING EVENT: number of merged voxels " << mergedVoxels.size() << " > " << parameters.m_maxMergedVoxels << std::endl;
+            PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::Reset(*pPrimaryPandora));
+            continue;
+        }
+
+        int hitCounter{0};
+        lar_content::LArEventHitVolumes::Get().Clear();
+        lar_content::LArEventHitVoxels::Get().Clear();
+        MakeCaloHitsFromVoxels(mergedVoxels, wireProjection, MCEnergyMap, pPrimaryPandora, eventParameters, hitCounter);
 
-        PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::ProcessEvent(*pPrimaryPandora));
-        PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::Reset(*pPrimaryPandora));
+        ProcessPrimaryEvent(pPrimaryPandora, hitCounter);
     }
 
     // Close input file
@@ -759,7 +1650,7 @@ MCParticleEnergyMap CreateEDepSimMCParticles(const TG4Event &event, const pandor
         return energyMap;
     }
 
-    lar_content::LArMCParticleFactory mcParticleFactory;
+    lar_content::LArPooledMCParticleFactory mcParticleFactory;
 
     // Loop over the initial primary neutrinos, storing their IDs and vertex positions inside vectors
     // since we need these to work out the associated neutrino ancestors for all MC trajectories
@@ -948,6 +1839,9 @@ void ProcessSEDEvents(const Parameters &parameters, const Pandora *const pPrimar
 
     const LArGrid grid = parameters.m_useModularGeometry ? MakeVoxelisationGrid(geom, parameters) : MakeVoxelisationGrid(pPrimaryPandora, parameters);
 
+    // Lookup tables for projecting the voxel grid lattice onto the wire coordinates
+    const LArWireProjection wireProjection(pPrimaryPandora->GetPlugins()->GetLArTransformationPlugin(), grid);
+
     std::cout << "Total grid volume: bot = " << grid.m_bottom << "\n top = " << grid.m_top << std::endl;
     std::cout << "Making voxels with size " << grid.m_binWidths << std::endl;
 
@@ -963,13 +1857,20 @@ void ProcessSEDEvents(const Parameters &parameters, const Pandora *const pPrimar
 
     std::cout << "Start event is " << startEvt << " and end event is " << endEvt - 1 << std::endl;
 
-    for (int iEvt = startEvt; iEvt < endEvt; iEvt++)
+    // The events of this process, if they are shared between child processes
+    int firstEvt(startEvt), lastEvt(endEvt), eventStride(1);
+    GetProcessEventRange(parameters, startEvt, endEvt, firstEvt, lastEvt, eventStride);
+
+    for (int iEvt = firstEvt; iEvt < lastEvt; iEvt += eventStride)
     {
         if (parameters.m_shouldDisplayEventNumber)
             std::cout << std::endl << "   PROCESSING EVENT: " << iEvt << std::endl << std::endl;
 
         ndsim->GetEntry(iEvt);
 
+        // Used to key the event records on the input entry
+        lar_content::LArProcessShard::Get().m_eventEntry = iEvt - startEvt;
+
         // Create MCParticles from Geant4 trajectories
         MCParticleEnergyMap MCEnergyMap;
         for (size_t imcp = 0; imcp < larsed.m_mcp_id->size(); ++imcp)
@@ -978,7 +1879,7 @@ void ProcessSEDEvents(const Parameters &parameters, const Pandora *const pPrimar
         }
         CreateSEDMCParticles(larsed, pPrimaryPandora, parameters);
 
-        LArVoxelList voxelList;
+        LArHitInfoList hitInfoList;
 
         // Loop over the energy deposits and create voxels
         for (size_t ised = 0; ised < larsed.m_sed_det->size(); ++ised)
@@ -997,34 +1898,43 @@ void ProcessSEDEvents(const Parameters &parameters, const Pandora *const pPrimar
                 const pandora::CartesianVector start(startx, starty, startz);
                 const pandora::CartesianVector end(endx, endy, endz);
 
-                const LArHitInfo hitInfo(start, end, energy, g4id, parameters.m_lengthScale, parameters.m_energyScale);
-                const LArVoxelList currentVoxelList = MakeVoxels(hitInfo, grid, parameters, geom);
-
-                for (const LArVoxel &voxel : currentVoxelList)
-                    voxelList.emplace_back(voxel);
+                hitInfoList.emplace_back(start, end, energy, g4id, parameters.m_lengthScale, parameters.m_energyScale);
             }
         }
 
+        LArVoxelList voxelList = MakeVoxels(hitInfoList, grid, parameters, geom);
+
         std::cout << "Produced " << voxelList.size() << " voxels from " << larsed.m_sed_det->size() << " hit segments." << std::endl;
 
         // Merge voxels with the same IDs
-        const LArVoxelList mergedVoxels = MergeSameVoxels(voxelList);
+        LArVoxelList mergedVoxels = MergeSameVoxels(voxelList);
+
+        // Represent straight runs of voxels by their end voxels, which keep the IDs of the voxels they represent through any sorting
+        if (parameters.m_maxCollinearRun > 0)
+            mergedVoxels = CompressCollinearVoxels(mergedVoxels, grid, parameters);
+
+        if (parameters.m_useMortonVoxelOrder)
+            SortVoxelsByID(mergedVoxels);
 
         std::cout << "Produced " << mergedVoxels.size() << " merged voxels from " << voxelList.size() << " voxels." << std::endl;
         voxelList.clear();
 
-        // Stop processing the event if we have too many voxels: reco takes too long
-        if (parameters.m_maxMergedVoxels > 0 && mergedVoxels.size() > parameters.m_maxMergedVoxels)
+        // If we have too many voxels, reco takes too long: re-bin them with larger voxels if allowed, otherwise skip the event
+        Parameters eventParameters(parameters);
+        if (parameters.m_maxMergedVoxels > 0 && mergedVoxels.size() > parameters.m_maxMergedVoxels &&
+            !CoarsenEventVoxels(grid, parameters, mergedVoxels, eventParameters.m_voxelWidth))
         {
             std::cout << "SKIPPING EVENT: number of merged voxels " << mergedVoxels.size() << " > " << parameters.m_maxMergedVoxels << std::endl;
-            break;
+            PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::Reset(*pPrimaryPandora));
+            continue;
         }
 
         int hitCounter{0};
-        MakeCaloHitsFromVoxels(mergedVoxels, MCEnergyMap, pPrimaryPandora, parameters, hitCounter);
+        lar_content::LArEventHitVolumes::Get().Clear();
+        lar_content::LArEventHitVoxels::Get().Clear();
+        MakeCaloHitsFromVoxels(mergedVoxels, wireProjection, MCEnergyMap, pPrimaryPandora, eventParameters, hitCounter);
 
-        PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::ProcessEvent(*pPrimaryPandora));
-        PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::Reset(*pPrimaryPandora));
+        ProcessPrimaryEvent(pPrimaryPandora, hitCounter);
     } // end event loop
 
     fileSource->Close();
@@ -1035,7 +1945,7 @@ void ProcessSEDEvents(const Parameters &parameters, const Pandora *const pPrimar
 void CreateSEDMCParticles(const LArSED &larsed, const pandora::Pandora *const pPrimaryPandora, const Parameters &parameters)
 {
 
-    lar_content::LArMCParticleFactory mcParticleFactory;
+    lar_content::LArPooledMCParticleFactory mcParticleFactory;
 
     const int nuidoffset(100000000);
 
@@ -1270,7 +2180,7 @@ LArGrid MakeVoxelisationGrid(const pandora::Pandora *const pPrimaryPandora, cons
     const float voxelWidth(parameters.m_voxelWidth);
 
     return LArGrid(pandora::CartesianVector(botX, botY, botZ), pandora::CartesianVector(topX, topY, topZ),
-        pandora::CartesianVector(voxelWidth, voxelWidth, voxelWidth));
+        pandora::CartesianVector(voxelWidth, voxelWidth, voxelWidth), parameters.m_useMortonVoxelOrder);
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -1287,12 +2197,12 @@ LArGrid MakeVoxelisationGrid(const LArNDGeomSimple &geom, const Parameters &para
     geom.GetSurroundingBox(minX, maxX, minY, maxY, minZ, maxZ);
 
     return LArGrid(pandora::CartesianVector(minX, minY, minZ), pandora::CartesianVector(maxX, maxY, maxZ),
-        pandora::CartesianVector(voxelWidth, voxelWidth, voxelWidth));
+        pandora::CartesianVector(voxelWidth, voxelWidth, voxelWidth), parameters.m_useMortonVoxelOrder);
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-LArVoxelList MakeVoxels(const LArHitInfo &hitInfo, const LArGrid &grid, const Parameters &parameters, const LArNDGeomSimple &geom)
+LArVoxelList MakeVoxels(const LArHitInfoList &hitInfoList, const LArGrid &grid, const Parameters &parameters, const LArNDGeomSimple &geom)
 {
     // Code based on
     // https://github.com/chenel/larcv2/tree/edepsim-formattruth/larcv/app/Supera/Voxelize.cxx
@@ -1300,87 +2210,128 @@ LArVoxelList MakeVoxels(const LArHitInfo &hitInfo, const LArGrid &grid, const Pa
 
     LArVoxelList currentVoxelList;
 
-    // Start and end positions
-    const pandora::CartesianVector start(hitInfo.m_start);
-    const pandora::CartesianVector stop(hitInfo.m_stop);
+    // The TPC boxes of a modular geometry, in TPC id order
+    std::vector<std::pair<unsigned int, LArBox>> tpcBoxes;
 
-    // Direction vector and hit segment length
-    const pandora::CartesianVector dir = stop - start;
-    const float hitLength(dir.GetMagnitude());
+    if (parameters.m_useModularGeometry)
+    {
+        for (const auto &tpcEntry : geom.m_TPCs)
+        {
+            const LArNDTPCSimple &tpc(tpcEntry.second);
+            const LArBox tpcBox(pandora::CartesianVector(tpc.m_x_min, tpc.m_y_min, tpc.m_z_min),
+                pandora::CartesianVector(tpc.m_x_max, tpc.m_y_max, tpc.m_z_max));
+            tpcBoxes.emplace_back(tpc.m_TPC_ID, tpcBox);
+        }
+    }
 
-    // Check hit length is greater than epsilon limit
-    if (hitLength < std::numeric_limits<float>::epsilon())
-        return currentVoxelList;
+    // The hit segments are clipped a batch at a time, each box being tested against the whole batch in one call
+    const size_t rayBatchSize(1024);
+    std::vector<LArRay> rays;
+    std::vector<size_t> rayHitIndices;
+    LArRayBatch rayBatch;
+    rays.reserve(rayBatchSize);
+    rayBatch.Reserve(rayBatchSize);
 
-    // Hit segment total energy in GeV (Geant4 uses MeV)
-    const float g4HitEnergy(hitInfo.m_energy);
+    std::vector<double> gridT0, gridT1;
+    std::vector<int> isGridHit;
+    std::vector<std::vector<double>> tpcT0(tpcBoxes.size()), tpcT1(tpcBoxes.size());
+    std::vector<std::vector<int>> isTPCHit(tpcBoxes.size());
 
-    // Check hit energy is greater than epsilon limit
-    if (g4HitEnergy < std::numeric_limits<float>::epsilon())
-        return currentVoxelList;
+    for (size_t firstHit = 0; firstHit < hitInfoList.size(); firstHit += rayBatchSize)
+    {
+        const size_t endHit(std::min(hitInfoList.size(), firstHit + rayBatchSize));
+        rays.clear();
+        rayHitIndices.clear();
+        rayBatch.Clear();
 
-    // Get the trackID of the (main) contributing particle.
-    // ATTN: this can very rarely be more than one track
-    const int trackID = hitInfo.m_trackID;
+        for (size_t iHit = firstHit; iHit < endHit; ++iHit)
+        {
+            const LArHitInfo &hitInfo(hitInfoList[iHit]);
 
-    // Define ray trajectory, which checks dirMag (hitLength) >= epsilon limit
-    const pandora::CartesianVector dirNorm = dir.GetUnitVector();
-    LArRay ray(start, dirNorm);
+            // Check hit length and hit segment total energy in GeV (Geant4 uses MeV) are greater than epsilon limit
+            const pandora::CartesianVector dir = hitInfo.m_stop - hitInfo.m_start;
+            if ((dir.GetMagnitude() < std::numeric_limits<float>::epsilon()) || (hitInfo.m_energy < std::numeric_limits<float>::epsilon()))
+                continue;
 
-    // We need to shuffle along the hit segment path and create voxels as we go.
-    // There are 4 cases for the start and end points inside the voxelisation region.
-    // Case 1: start & stop are both inside the voxelisation boundary
-    // Case 2: start & stop are both outside, but path direction intersects boundary
-    // Case 3: start is inside boundary, stop = intersection at region boundary
-    // Case 4: end is inside boundary, start = intersection at region boundary
+            // Define ray trajectory, which checks dirMag (hitLength) >= epsilon limit
+            rays.emplace_back(hitInfo.m_start, dir.GetUnitVector());
+            rayHitIndices.push_back(iHit);
+            rayBatch.AddRay(rays.back());
+        }
 
-    double t0(0.0), t1(0.0);
-    pandora::CartesianVector point1(0.f, 0.f, 0.f), point2(0.f, 0.f, 0.f);
+        grid.Intersect(rayBatch, gridT0, gridT1, isGridHit);
 
-    // Check if the start and end points are inside the voxelisation region
-    const bool inStart = grid.Inside(start);
-    const bool inStop = grid.Inside(stop);
+        for (size_t iTPC = 0; iTPC < tpcBoxes.size(); ++iTPC)
+            tpcBoxes[iTPC].second.Intersect(rayBatch, tpcT0[iTPC], tpcT1[iTPC], isTPCHit[iTPC]);
 
-    if (inStart && inStop)
-    {
-        // Case 1: Start and end points are inside boundary
-        point1 = start;
-        point2 = stop;
-    }
-    else if (!inStart && !inStop)
-    {
-        // Case 2: Start and end points are outside boundary
-        if (grid.Intersect(ray, t0, t1))
+        for (size_t iRay = 0; iRay < rays.size(); ++iRay)
         {
-            point1 = ray.GetPoint(t0);
-            point2 = ray.GetPoint(t1);
+            const LArHitInfo &hitInfo(hitInfoList[rayHitIndices[iRay]]);
+            LArRay &ray(rays[iRay]);
+
+            const float hitLength((hitInfo.m_stop - hitInfo.m_start).GetMagnitude());
+            const float g4HitEnergy(hitInfo.m_energy);
+
+            // Get the trackID of the (main) contributing particle.
+            // ATTN: this can very rarely be more than one track
+            const int trackID = hitInfo.m_trackID;
+
+            // We need to shuffle along the hit segment path and create voxels as we go.
+            // There are 4 cases for the start and end points inside the voxelisation region.
+            // Case 1: start & stop are both inside the voxelisation boundary
+            // Case 2: start & stop are both outside, but path direction intersects boundary
+            // Case 3: start is inside boundary, stop = intersection at region boundary
+            // Case 4: end is inside boundary, start = intersection at region boundary
+            const bool inStart = grid.Inside(hitInfo.m_start);
+            const bool inStop = grid.Inside(hitInfo.m_stop);
+
+            // Outside the voxelisation region, unless the path direction intersects its boundary
+            if (!(inStart && inStop) && !isGridHit[iRay])
+                continue;
+
+            // Cases 1 and 3 start at the start point, cases 2 and 4 at the first boundary intersection
+            const pandora::CartesianVector point1(inStart ? hitInfo.m_start : ray.GetPoint(gridT0[iRay]));
+
+            if (parameters.m_useModularGeometry)
+            {
+                // Clip the hit segment against each TPC box once, then voxelise each sub-segment with its TPC already known
+                for (size_t iTPC = 0; iTPC < tpcBoxes.size(); ++iTPC)
+                {
+                    if (!isTPCHit[iTPC][iRay])
+                        continue;
+
+                    // Restrict the intersection to the hit segment itself
+                    const double tStart(std::max(tpcT0[iTPC][iRay], 0.0));
+                    const double tEnd(std::min(tpcT1[iTPC][iRay], static_cast<double>(hitLength)));
+                    const float tpcPathLength(tEnd - tStart);
+
+                    if (tpcPathLength < std::numeric_limits<float>::epsilon())
+                        continue;
+
+                    LArRay tpcRay(ray.GetPoint(tStart), ray.m_dir);
+                    AddSegmentVoxels(tpcRay, tpcPathLength, hitLength, g4HitEnergy, trackID, tpcBoxes[iTPC].first, grid, parameters,
+                        currentVoxelList);
+                }
+            }
+            else
+            {
+                // Now create voxels from point1 along the hit segment.
+                // Ray direction will be the same, but update starting point
+                ray.UpdateOrigin(point1);
+                AddSegmentVoxels(ray, hitLength, hitLength, g4HitEnergy, trackID, 0, grid, parameters, currentVoxelList);
+            }
         }
-        else
-            return currentVoxelList;
-    }
-    else if (inStart && !inStop)
-    {
-        // Case 3: Start inside boundary
-        point1 = start;
-        if (grid.Intersect(ray, t0, t1))
-            point2 = ray.GetPoint(t1);
-        else
-            return currentVoxelList;
-    }
-    else if (!inStart && inStop)
-    {
-        // Case 4: End inside boundary
-        point2 = stop;
-        if (grid.Intersect(ray, t0, t1))
-            point1 = ray.GetPoint(t0);
-        else
-            return currentVoxelList;
     }
 
-    // Now create voxels between point1 and point2.
-    // Ray direction will be the same, but update starting point
-    ray.UpdateOrigin(point1);
+    return currentVoxelList;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
 
+void AddSegmentVoxels(LArRay &ray, const float pathLength, const float hitLength, const float hitEnergy, const int trackID,
+    const unsigned int tpcID, const LArGrid &grid, const Parameters &parameters, LArVoxelList &voxelList)
+{
+    double t0(0.0), t1(0.0);
     bool shuffle(true);
 
     // Keep track of total voxel path length so far
@@ -1426,42 +2377,25 @@ LArVoxelList MakeVoxels(const LArHitInfo &hitInfo, const LArGrid &grid, const Pa
         totalPath += dL;
 
         // Stop adding voxels if we have enough
-        if (totalPath > hitLength)
+        if (totalPath > pathLength)
         {
             shuffle = false;
-            // Adjust final path according to hit segment total length
-            dL = hitLength - totalPath + dL;
+            // Adjust final path according to the path length
+            dL = pathLength - totalPath + dL;
         }
 
         // Voxel energy (GeV) using path length fraction w.r.t hit length.
         // Here, hitLength is guaranteed to be greater than zero
-        const float voxelEnergy(g4HitEnergy * dL / hitLength);
+        const float voxelEnergy(hitEnergy * dL / hitLength);
 
-        if (parameters.m_useModularGeometry)
-        {
-            // If using modular geometry we need to assign the tpc number
-            const int tpcID(geom.GetTPCNumber(voxelPoint));
-            if (tpcID != -1)
-            {
-                const LArVoxel voxel(voxelID, voxelEnergy, voxBot, trackID, tpcID);
-                currentVoxelList.emplace_back(voxel);
-            }
-            else
-                std::cout << "Hit not in TPC: " << voxelPoint << std::endl;
-        }
-        else
-        {
-            const LArVoxel voxel(voxelID, voxelEnergy, voxBot, trackID);
-            currentVoxelList.emplace_back(voxel);
-        }
+        const LArVoxel voxel(voxelID, voxelEnergy, voxBot, trackID, tpcID);
+        voxelList.emplace_back(voxel);
 
         // Update ray starting position using intersection path difference
         const pandora::CartesianVector newStart = ray.GetPoint(dL);
         ray.UpdateOrigin(newStart);
         loop++;
     }
-
-    return currentVoxelList;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -1470,128 +2404,221 @@ LArVoxelList MergeSameVoxels(const LArVoxelList &voxelList)
 {
     std::cout << "Merging voxels with the same IDs" << std::endl;
     LArVoxelList mergedVoxels;
+    mergedVoxels.reserve(voxelList.size());
+
+    // Index of the merged voxel for each voxel ID, keeping the order of first occurrence
+    std::unordered_map<long, size_t> voxelIDToIndex;
+    voxelIDToIndex.reserve(voxelList.size());
+
+    for (const LArVoxel &voxel : voxelList)
+    {
+        const auto iter = voxelIDToIndex.find(voxel.m_voxelID);
+        if (iter == voxelIDToIndex.end())
+        {
+            voxelIDToIndex.emplace(voxel.m_voxelID, mergedVoxels.size());
+            mergedVoxels.emplace_back(voxel);
+            continue;
+        }
+
+        // IDs match. Add energy and amend the true particle contributions
+        LArVoxel &mergedVoxel = mergedVoxels[iter->second];
+        mergedVoxel.SetEnergy(mergedVoxel.m_energyInVoxel + voxel.m_energyInVoxel);
+        mergedVoxel.m_mcContributions.Add(voxel.m_mcContributions);
+        mergedVoxel.SetTrackID(mergedVoxel.m_mcContributions.GetMainTrackID());
+    }
+
+    return mergedVoxels;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+LArVoxelList CompressCollinearVoxels(const LArVoxelList &voxelList, const LArGrid &grid, const Parameters &parameters)
+{
+    const size_t nVoxels(voxelList.size());
+    const size_t maxRun(parameters.m_maxCollinearRun > 2 ? parameters.m_maxCollinearRun : 2);
 
-    const int nVoxels = voxelList.size();
-    std::vector<bool> processed(nVoxels, false);
+    // Voxels of a straight track are all within about one voxel width of the line joining the run end points
+    const float tolerance(grid.m_binWidths.GetX());
 
-    for (int i = 0; i < nVoxels; i++)
+    // Consecutive voxels belong to the same chain if they are face, edge or corner neighbours in the same TPC, with the same
+    // main track, so that a run never hands the energy of one particle to another at a vertex or crossing
+    std::vector<bool> continuesChain(nVoxels, false);
+    for (size_t i = 1; i < nVoxels; ++i)
     {
-        // Skip voxel if it was already used in a merge
-        if (processed[i])
+        const LArVoxel &voxel1(voxelList[i - 1]);
+        const LArVoxel &voxel2(voxelList[i]);
+
+        if (voxel1.m_tpcID != voxel2.m_tpcID || voxel1.m_trackID != voxel2.m_trackID)
             continue;
 
-        LArVoxel voxel1 = voxelList[i];
-        float voxE1 = voxel1.m_energyInVoxel;
-        std::map<int, float> trackIDToEnergy;
-        trackIDToEnergy[voxel1.m_trackID] = voxE1;
+        const LongBin4Array bins1 = grid.GetBinIndices(voxel1.m_voxelID);
+        const LongBin4Array bins2 = grid.GetBinIndices(voxel2.m_voxelID);
+        continuesChain[i] = std::abs(bins1[0] - bins2[0]) <= 1 && std::abs(bins1[1] - bins2[1]) <= 1 && std::abs(bins1[2] - bins2[2]) <= 1;
+    }
+
+    // Choose the run end (anchor) voxels: extend each run while its voxels stay close to the line joining its ends
+    std::vector<bool> isAnchor(nVoxels, false);
+    for (size_t i = 0; i < nVoxels; ++i)
+    {
+        if (i == 0 || !continuesChain[i] || i + 1 == nVoxels || !continuesChain[i + 1])
+            isAnchor[i] = true;
+    }
 
-        // Loop over other voxels (from i+1) and check if we have an ID match.
-        // If so, add their energies and only store the combined voxel at the end
-        for (int j = i + 1; j < nVoxels; j++)
+    size_t start(0);
+    while (start < nVoxels)
+    {
+        size_t end(start + 1);
+        while (end < nVoxels && !isAnchor[end])
         {
-            // Skip voxel if it was already used in a merge
-            if (processed[j])
-                continue;
+            // Check the run start..end+1, whose end would be the next voxel
+            const size_t next(end + 1);
+            bool isCollinear(next - start < maxRun);
+            const pandora::CartesianVector &startPos(voxelList[start].m_voxelPosVect);
+            const pandora::CartesianVector direction(voxelList[next].m_voxelPosVect - startPos);
+            const float length(direction.GetMagnitude());
+
+            for (size_t k = start + 1; isCollinear && k < next && length > 0.f; ++k)
+            {
+                const pandora::CartesianVector offset(voxelList[k].m_voxelPosVect - startPos);
+                if (direction.GetCrossProduct(offset).GetMagnitude() / length > tolerance)
+                    isCollinear = false;
+            }
 
-            const LArVoxel voxel2 = voxelList[j];
-            const int trackid2 = voxel2.m_trackID;
-            const float voxE2 = voxel2.m_energyInVoxel;
-            if (voxel2.m_voxelID == voxel1.m_voxelID)
+            if (!isCollinear)
             {
-                // IDs match. Add energy and set processed integer
-                voxE1 += voxE2;
-                processed[j] = true;
-                // Amend the true particle contribution map
-                if (trackIDToEnergy.count(trackid2) != 0)
-                    trackIDToEnergy[trackid2] += voxE2;
-                else
-                    trackIDToEnergy[trackid2] = voxE2;
+                isAnchor[end] = true;
+                break;
             }
+
+            ++end;
         }
 
-        // Add combined (or untouched) voxel to the merged list
-        voxel1.SetEnergy(voxE1);
-        // Update the track ID if necessary
-        if (trackIDToEnergy.size() > 1)
+        start = end;
+    }
+
+    // Add each voxel to the nearest anchor along its chain, keeping the anchor positions and IDs along with the IDs of the
+    // voxels that each anchor represents, and the first and last of those voxels along the chain
+    LArVoxelList compressedVoxels;
+    std::vector<size_t> anchorIndices(nVoxels, 0), firstIndices, lastIndices;
+    for (size_t i = 0; i < nVoxels; ++i)
+    {
+        if (!isAnchor[i])
+            continue;
+
+        anchorIndices[i] = compressedVoxels.size();
+        compressedVoxels.emplace_back(voxelList[i]);
+        firstIndices.emplace_back(i);
+        lastIndices.emplace_back(i);
+    }
+
+    size_t previousAnchor(0);
+    for (size_t i = 0; i < nVoxels; ++i)
+    {
+        if (isAnchor[i])
         {
-            float highestEnergy{0.f};
-            int bestTrackID{-1};
-            // std::cout << "Merged voxel had contributions from " << trackIDToEnergy.size() << " particles" << std::endl;
-            for (auto const &pair : trackIDToEnergy)
-            {
-                // std::cout << " - " << pair.first << " with energy " << pair.second << std::endl;
-                if (pair.second > highestEnergy)
-                {
-                    highestEnergy = pair.second;
-                    bestTrackID = pair.first;
-                }
-            }
-            // std::cout << " = chose track id " << bestTrackID << std::endl;
-            voxel1.SetTrackID(bestTrackID);
+            previousAnchor = i;
+            continue;
         }
 
-        mergedVoxels.emplace_back(voxel1);
+        size_t nextAnchor(i + 1);
+        while (!isAnchor[nextAnchor])
+            ++nextAnchor;
 
-        // We have processed the ith voxel
-        processed[i] = true;
+        const size_t anchor(i - previousAnchor <= nextAnchor - i ? previousAnchor : nextAnchor);
+        LArVoxel &compressedVoxel = compressedVoxels[anchorIndices[anchor]];
+        compressedVoxel.SetEnergy(compressedVoxel.m_energyInVoxel + voxelList[i].m_energyInVoxel);
+        compressedVoxel.m_mcContributions.Add(voxelList[i].m_mcContributions);
+        compressedVoxel.SetTrackID(compressedVoxel.m_mcContributions.GetMainTrackID());
+        compressedVoxel.AddInputVoxels(voxelList[i]);
+        firstIndices[anchorIndices[anchor]] = std::min(firstIndices[anchorIndices[anchor]], i);
+        lastIndices[anchorIndices[anchor]] = std::max(lastIndices[anchorIndices[anchor]], i);
     }
 
-    return mergedVoxels;
+    // The calo hits made from each compressed voxel are widened to cover the voxels that it represents
+    for (size_t c = 0; c < compressedVoxels.size(); ++c)
+        compressedVoxels[c].m_runVector = voxelList[lastIndices[c]].m_voxelPosVect - voxelList[firstIndices[c]].m_voxelPosVect;
+
+    std::cout << "Compressed " << nVoxels << " voxels into " << compressedVoxels.size() << " collinear run voxels" << std::endl;
+    return compressedVoxels;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-LArVoxelProjectionList MergeSameProjections(const LArVoxelProjectionList &hits)
+bool CoarsenEventVoxels(const LArGrid &grid, const Parameters &parameters, LArVoxelList &mergedVoxels, float &voxelWidth)
 {
-    LArVoxelProjectionList outputHits;
-    std::vector<bool> areUsed(hits.size(), false);
+    voxelWidth = parameters.m_voxelWidth;
 
-    for (unsigned int vp1 = 0; vp1 < hits.size(); ++vp1)
+    // Climb the voxel pyramid until a level has few enough voxels
+    LArVoxelPyramid pyramid(grid, mergedVoxels, parameters.m_voxelPyramidFactor);
+
+    for (int level = 1; level <= parameters.m_maxVoxelCoarsening; ++level)
     {
-        if (areUsed.at(vp1))
+        if (!pyramid.AddLevel())
+            break;
+
+        const LArVoxelList &coarseVoxels = pyramid.GetLevel(level).m_voxels;
+        if (coarseVoxels.size() > static_cast<size_t>(parameters.m_maxMergedVoxels))
             continue;
 
-        LArVoxelProjection voxProj1{hits.at(vp1)};
-        std::map<int, float> trackIDToEnergy;
-        trackIDToEnergy[voxProj1.m_trackID] = voxProj1.m_energy;
-        for (unsigned int vp2 = vp1 + 1; vp2 < hits.size(); ++vp2)
-        {
-            if (areUsed.at(vp2))
-                continue;
+        const float coarseWidth(parameters.m_voxelWidth * pyramid.GetScale(level));
+        std::cout << "COARSENED EVENT: merged " << mergedVoxels.size() << " voxels into " << coarseVoxels.size() << " using voxel width "
+                  << coarseWidth << " cm" << std::endl;
 
-            const LArVoxelProjection &voxProj2 = hits.at(vp2);
-            if ((voxProj1.m_wire != voxProj2.m_wire) || (voxProj1.m_drift != voxProj2.m_drift))
-                continue;
+        mergedVoxels = coarseVoxels;
+        if (parameters.m_useMortonVoxelOrder)
+            SortVoxelsByID(mergedVoxels);
 
-            // Add the energy, but keep track of the highest energy contributor
-            voxProj1.m_energy += voxProj2.m_energy;
-            if (trackIDToEnergy.count(voxProj2.m_trackID) != 0)
-                trackIDToEnergy[voxProj2.m_trackID] += voxProj2.m_energy;
-            else
-                trackIDToEnergy[voxProj2.m_trackID] = voxProj2.m_energy;
+        voxelWidth = coarseWidth;
+        return true;
+    }
+
+    return false;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void SortVoxelsByID(LArVoxelList &voxelList)
+{
+    std::sort(voxelList.begin(), voxelList.end(), [](const LArVoxel &lhs, const LArVoxel &rhs) { return lhs.m_voxelID < rhs.m_voxelID; });
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+LArVoxelProjectionList MergeSameProjections(const LArVoxelProjectionList &hits, const bool mergeAcrossTPCs)
+{
+    LArVoxelProjectionList outputHits;
+    outputHits.reserve(hits.size());
+
+    // Index of the merged hit for each (wire, drift, TPC) position, along with the energy of its largest individual projection
+    std::map<std::tuple<float, float, int>, size_t> positionToIndex;
+    std::vector<float> largestEnergies;
+    largestEnergies.reserve(hits.size());
 
-            areUsed.at(vp2) = true;
+    for (const LArVoxelProjection &hit : hits)
+    {
+        const std::tuple<float, float, int> position(hit.m_wire, hit.m_drift, mergeAcrossTPCs ? 0 : hit.m_tpcID);
+        const auto iter = positionToIndex.find(position);
+        if (iter == positionToIndex.end())
+        {
+            positionToIndex.emplace(position, outputHits.size());
+            outputHits.emplace_back(hit);
+            largestEnergies.emplace_back(hit.m_energy);
+            continue;
         }
-        // Add the hit to the output
-        areUsed.at(vp1) = true;
 
-        // Update the track ID if necessary
-        if (trackIDToEnergy.size() > 1)
+        // Add the energy, but keep track of the true particle contributions
+        LArVoxelProjection &mergedHit = outputHits[iter->second];
+        mergedHit.m_energy += hit.m_energy;
+        mergedHit.m_mcContributions.Add(hit.m_mcContributions);
+        mergedHit.m_trackID = mergedHit.m_mcContributions.GetMainTrackID();
+        mergedHit.m_driftSpan = std::max(mergedHit.m_driftSpan, hit.m_driftSpan);
+
+        // The parent voxel is the one providing the largest projection
+        if (hit.m_energy > largestEnergies[iter->second])
         {
-            float highestEnergy{0.f};
-            int bestTrackID{-1};
-            for (auto const &pair : trackIDToEnergy)
-            {
-                if (pair.second > highestEnergy)
-                {
-                    highestEnergy = pair.second;
-                    bestTrackID = pair.first;
-                }
-            }
-            voxProj1.m_trackID = bestTrackID;
-            voxProj1.m_parentVoxelID = hits.at(bestTrackID).m_parentVoxelID;
+            largestEnergies[iter->second] = hit.m_energy;
+            mergedHit.m_parentVoxelID = hit.m_parentVoxelID;
         }
-        outputHits.emplace_back(voxProj1);
     }
 
     std::cout << outputHits.size() << " projected hits remain after merging" << std::endl;
@@ -1600,12 +2627,12 @@ LArVoxelProjectionList MergeSameProjections(const LArVoxelProjectionList &hits)
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void MakeCaloHitsFromVoxels(const LArVoxelList &voxels, const MCParticleEnergyMap &mcEnergyMap,
+void MakeCaloHitsFromVoxels(const LArVoxelList &voxels, const LArWireProjection &wireProjection, const MCParticleEnergyMap &mcEnergyMap,
     const pandora::Pandora *const pPrimaryPandora, const Parameters &parameters, int &hitCounter)
 {
 
     // Factory for creating LArCaloHits
-    lar_content::LArCaloHitFactory m_larCaloHitFactory;
+    lar_content::LArPooledCaloHitFactory m_larCaloHitFactory;
     const float voxelWidth(parameters.m_voxelWidth);
     const float MipE = 0.00075;
     lar_content::LArCaloHitParameters caloHitParameters = MakeDefaultCaloHitParams(voxelWidth);
@@ -1631,13 +2658,20 @@ void MakeCaloHitsFromVoxels(const LArVoxelList &voxels, const MCParticleEnergyMa
             caloHitParameters.m_pParentAddress = (void *)(static_cast<uintptr_t>(++hitCounter));
             caloHitParameters.m_larTPCVolumeId = voxel.m_tpcID;
 
-            PANDORA_THROW_RESULT_IF(
-                pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::CaloHit::Create(*pPrimaryPandora, caloHitParameters, m_larCaloHitFactory));
+            // A voxel representing a collinear run is a cell stretched along the run, so the run has no gaps
+            const float runLength(voxel.m_runVector.GetMagnitude());
+            caloHitParameters.m_cellNormalVector =
+                runLength > 0.f ? voxel.m_runVector.GetUnitVector() : pandora::CartesianVector(0.f, 0.f, 1.f);
+            caloHitParameters.m_cellThickness = voxelWidth + runLength;
+
+            CreateLArCaloHit(pPrimaryPandora, caloHitParameters, m_larCaloHitFactory);
 
-            // Set calo hit voxel to MCParticle relation using trackID
-            const int trackID = voxel.m_trackID;
-            const float energyFrac = GetMCEnergyFraction(mcEnergyMap, voxelE, trackID);
-            PandoraApi::SetCaloHitToMCParticleRelationship(*pPrimaryPandora, (void *)((intptr_t)hitCounter), (void *)((intptr_t)trackID), energyFrac);
+            // Record the original voxels of the hit, for the analysis output
+            lar_content::LArEventHitVoxels::Get().AddHit(caloHitParameters.m_pParentAddress.Get(),
+                voxel.m_inputVoxelIDs.empty() ? std::vector<long>(1, voxel.m_voxelID) : voxel.m_inputVoxelIDs);
+
+            // Set calo hit voxel to MCParticle relations using the contributing trackIDs
+            SetCaloHitMCParticleRelationships(voxel.m_mcContributions, mcEnergyMap, pPrimaryPandora, hitCounter);
         }
     }
 
@@ -1654,28 +2688,37 @@ void MakeCaloHitsFromVoxels(const LArVoxelList &voxels, const MCParticleEnergyMa
             const LArVoxel &voxel = voxels.at(v);
 
             const pandora::CartesianVector voxelPos = voxel.m_voxelPosVect;
-            const float uPos(pPrimaryPandora->GetPlugins()->GetLArTransformationPlugin()->YZtoU(voxelPos.GetY(), voxelPos.GetZ()));
+            float uPos(0.f), vPos(0.f), wPos(0.f);
+            wireProjection.Project(voxel, uPos, vPos, wPos);
+
             voxelProjectionsU.emplace_back(LArVoxelProjection(
-                voxel.m_energyInVoxel, uPos, voxelPos.GetX(), pandora::TPC_VIEW_U, voxel.m_voxelID, voxel.m_trackID, voxel.m_tpcID));
+                voxel.m_energyInVoxel, uPos, voxelPos.GetX(), pandora::TPC_VIEW_U, voxel.m_voxelID, voxel.m_mcContributions, voxel.m_tpcID));
 
-            const float vPos(pPrimaryPandora->GetPlugins()->GetLArTransformationPlugin()->YZtoV(voxelPos.GetY(), voxelPos.GetZ()));
             voxelProjectionsV.emplace_back(LArVoxelProjection(
-                voxel.m_energyInVoxel, vPos, voxelPos.GetX(), pandora::TPC_VIEW_V, voxel.m_voxelID, voxel.m_trackID, voxel.m_tpcID));
+                voxel.m_energyInVoxel, vPos, voxelPos.GetX(), pandora::TPC_VIEW_V, voxel.m_voxelID, voxel.m_mcContributions, voxel.m_tpcID));
 
-            const float wPos(pPrimaryPandora->GetPlugins()->GetLArTransformationPlugin()->YZtoW(voxelPos.GetY(), voxelPos.GetZ()));
             voxelProjectionsW.emplace_back(LArVoxelProjection(
-                voxel.m_energyInVoxel, wPos, voxelPos.GetX(), pandora::TPC_VIEW_W, voxel.m_voxelID, voxel.m_trackID, voxel.m_tpcID));
+                voxel.m_energyInVoxel, wPos, voxelPos.GetX(), pandora::TPC_VIEW_W, voxel.m_voxelID, voxel.m_mcContributions, voxel.m_tpcID));
+
+            const float driftSpan(std::fabs(voxel.m_runVector.GetX()));
+            voxelProjectionsU.back().m_driftSpan = driftSpan;
+            voxelProjectionsV.back().m_driftSpan = driftSpan;
+            voxelProjectionsW.back().m_driftSpan = driftSpan;
         }
 
         std::vector<LArVoxelProjectionList> viewProjections;
-        viewProjections.emplace_back(MergeSameProjections(voxelProjectionsU));
-        viewProjections.emplace_back(MergeSameProjections(voxelProjectionsV));
-        viewProjections.emplace_back(MergeSameProjections(voxelProjectionsW));
+        viewProjections.emplace_back(MergeSameProjections(voxelProjectionsU, true));
+        viewProjections.emplace_back(MergeSameProjections(voxelProjectionsV, true));
+        viewProjections.emplace_back(MergeSameProjections(voxelProjectionsW, true));
 
         voxelProjectionsU.clear();
         voxelProjectionsV.clear();
         voxelProjectionsW.clear();
 
+        // Undo the 3D run cell shapes; the 2D hits of a collinear run are widened along the drift direction instead
+        caloHitParameters.m_cellNormalVector = pandora::CartesianVector(0.f, 0.f, 1.f);
+        caloHitParameters.m_cellThickness = voxelWidth;
+
         for (const LArVoxelProjectionList &view : viewProjections)
         {
             for (const LArVoxelProjection &hit : view)
@@ -1695,15 +2738,13 @@ void MakeCaloHitsFromVoxels(const LArVoxelList &voxels, const MCParticleEnergyMa
                 caloHitParameters.m_pParentAddress = (void *)(static_cast<uintptr_t>(++hitCounter));
                 caloHitParameters.m_hitType = hit.m_view;
                 caloHitParameters.m_larTPCVolumeId = hit.m_tpcID;
+                caloHitParameters.m_cellSize1 = voxelWidth + hit.m_driftSpan;
 
                 // Create LArCaloHits for U, V and W views
-                PANDORA_THROW_RESULT_IF(
-                    pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::CaloHit::Create(*pPrimaryPandora, caloHitParameters, m_larCaloHitFactory));
+                CreateLArCaloHit(pPrimaryPandora, caloHitParameters, m_larCaloHitFactory);
 
-                // Set calo hit voxel to MCParticle relation using trackID
-                const int trackID = hit.m_trackID;
-                const float energyFrac = GetMCEnergyFraction(mcEnergyMap, voxelE, trackID);
-                PandoraApi::SetCaloHitToMCParticleRelationship(*pPrimaryPandora, (void *)((intptr_t)hitCounter), (void *)((intptr_t)trackID), energyFrac);
+                // Set calo hit voxel to MCParticle relations using the contributing trackIDs
+                SetCaloHitMCParticleRelationships(hit.m_mcContributions, mcEnergyMap, pPrimaryPandora, hitCounter);
             } // end voxel projection loop
         } // end view loop
     }
@@ -1711,7 +2752,56 @@ void MakeCaloHitsFromVoxels(const LArVoxelList &voxels, const MCParticleEnergyMa
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-float GetMCEnergyFraction(const MCParticleEnergyMap &mcEnergyMap, const float voxelE, const int trackID)
+void CreateLArCaloHit(const pandora::Pandora *const pPrimaryPandora, const lar_content::LArCaloHitParameters &caloHitParameters,
+    const lar_content::LArCaloHitFactory &larCaloHitFactory)
+{
+    PANDORA_THROW_RESULT_IF(
+        pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::CaloHit::Create(*pPrimaryPandora, caloHitParameters, larCaloHitFactory));
+
+    lar_content::LArEventHitVolumes::Get().AddHit(caloHitParameters.m_pParentAddress.Get(), caloHitParameters.m_larTPCVolumeId.Get(),
+        caloHitParameters.m_positionVector.Get().GetX());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void ProcessPrimaryEvent(const pandora::Pandora *const pPrimaryPandora, const int nHits)
+{
+    lar_content::LArProfile &profile(lar_content::LArProfile::Get());
+
+    if (!profile.IsEnabled())
+    {
+        PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::ProcessEvent(*pPrimaryPandora));
+    }
+    else
+    {
+        profile.SetInstanceEvent(pPrimaryPandora, -1, nHits);
+        const double startWallTime(lar_content::LArProfile::GetWallTime()), startCPUTime(lar_content::LArProfile::GetCPUTime());
+        const pandora::StatusCode statusCode(PandoraApi::ProcessEvent(*pPrimaryPandora));
+        profile.AddEntry(pPrimaryPandora, "ProcessEvent", -1, lar_content::LArProfile::GetWallTime() - startWallTime,
+            lar_content::LArProfile::GetCPUTime() - startCPUTime);
+        profile.EndEvent();
+        PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, statusCode);
+    }
+
+    PANDORA_THROW_RESULT_IF(pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::Reset(*pPrimaryPandora));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void SetCaloHitMCParticleRelationships(const LArMCContributions &mcContributions, const MCParticleEnergyMap &mcEnergyMap,
+    const pandora::Pandora *const pPrimaryPandora, const int hitCounter)
+{
+    for (unsigned int i = 0; i < mcContributions.m_nContributors; ++i)
+    {
+        const long trackID = mcContributions.m_trackIDs[i];
+        const float energyFrac = GetMCEnergyFraction(mcEnergyMap, mcContributions.m_energies[i], trackID);
+        PandoraApi::SetCaloHitToMCParticleRelationship(*pPrimaryPandora, (void *)((intptr_t)hitCounter), (void *)((intptr_t)trackID), energyFrac);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+float GetMCEnergyFraction(const MCParticleEnergyMap &mcEnergyMap, const float voxelE, const long trackID)
 {
     // Find the energy fraction: voxelHitE/MCParticleE
     float energyFrac(0.f), MCEnergy(0.f);
@@ -1772,7 +2862,7 @@ bool ParseCommandLine(int argc, char *argv[], Parameters &parameters)
     std::string geomVolName("");
     std::string sensDetName("");
 
-    while ((cOpt = getopt(argc, argv, "r:i:e:k:f:g:t:v:d:n:s:j:w:m:b:c:MpNh")) != -1)
+    while ((cOpt = getopt(argc, argv, "r:i:e:k:f:g:o:t:v:d:n:s:j:w:m:a:x:q:l:b:c:y:u:P:S:T:BGMpNZh")) != -1)
     {
         switch (cOpt)
         {
@@ -1794,6 +2884,12 @@ bool ParseCommandLine(int argc, char *argv[], Parameters &parameters)
             case 'g':
                 parameters.m_geomFileName = optarg;
                 break;
+            case 'o':
+                parameters.m_geomCacheFileName = optarg;
+                break;
+            case 'G':
+                parameters.m_onlyWriteGeomCache = true;
+                break;
             case 't':
                 geomManagerName = optarg;
                 break;
@@ -1815,6 +2911,18 @@ bool ParseCommandLine(int argc, char *argv[], Parameters &parameters)
             case 'p':
                 parameters.m_printOverallRecoStatus = true;
                 break;
+            case 'P':
+                parameters.m_nProcesses = atoi(optarg);
+                break;
+            case 'B':
+                parameters.m_blockPartitionEvents = true;
+                break;
+            case 'S':
+                parameters.m_serverSpoolName = optarg;
+                break;
+            case 'T':
+                parameters.m_profileFileName = optarg;
+                break;
             case 'j':
                 viewOption = optarg;
                 break;
@@ -1824,15 +2932,36 @@ bool ParseCommandLine(int argc, char *argv[], Parameters &parameters)
             case 'm':
                 parameters.m_maxMergedVoxels = atoi(optarg);
                 break;
+            case 'a':
+                parameters.m_maxVoxelCoarsening = atoi(optarg);
+                break;
+            case 'q':
+                parameters.m_spProjectionMergeWidth = atof(optarg);
+                break;
+            case 'l':
+                parameters.m_maxCollinearRun = atoi(optarg);
+                break;
+            case 'x':
+                parameters.m_voxelPyramidFactor = atoi(optarg);
+                break;
             case 'b':
                 parameters.m_minNSpacePoints = atoi(optarg);
                 break;
             case 'c':
                 parameters.m_minVoxelMipEquivE = atof(optarg);
                 break;
+            case 'y':
+                parameters.m_subEventTimeGap = atof(optarg);
+                break;
+            case 'u':
+                parameters.m_minSubEventSPs = atoi(optarg);
+                break;
             case 'N':
                 parameters.m_shouldDisplayEventNumber = true;
                 break;
+            case 'Z':
+                parameters.m_useMortonVoxelOrder = true;
+                break;
             case 'h':
             default:
                 return PrintOptions();
@@ -1841,8 +2970,17 @@ bool ParseCommandLine(int argc, char *argv[], Parameters &parameters)
 
     ProcessViewOption(viewOption, parameters);
     const bool gotFormat = ProcessFormatOption(formatOption, inputTreeName, geomManagerName, geomVolName, sensDetName, parameters);
-    const bool gotRecoOpt = ProcessRecoOption(recoOption, parameters);
-    const bool passed = gotFormat && gotRecoOpt;
+    // Building the geometry cache does not run any reconstruction
+    const bool gotRecoOpt = parameters.m_onlyWriteGeomCache || ProcessRecoOption(recoOption, parameters);
+    const bool gotGeomCache = !parameters.m_onlyWriteGeomCache || !parameters.m_geomCacheFileName.empty();
+    // A server processes each input file in a single process
+    const bool gotServerOpt = parameters.m_serverSpoolName.empty() || (parameters.m_nProcesses <= 1);
+    // Only the space point formats have the times used to split spills into sub-events
+    const bool gotSubEventOpt = (parameters.m_subEventTimeGap <= 0.f) ||
+        (parameters.m_dataFormat == Parameters::LArNDFormat::SP) || (parameters.m_dataFormat == Parameters::LArNDFormat::SPMC);
+    // Each coarser voxel level is 2 to 4 times wider than the one below
+    const bool gotPyramidOpt = (parameters.m_voxelPyramidFactor >= 2) && (parameters.m_voxelPyramidFactor <= 4);
+    const bool passed = gotFormat && gotRecoOpt && gotGeomCache && gotServerOpt && gotSubEventOpt && gotPyramidOpt;
     if (!passed)
     {
         return PrintOptions();
@@ -1859,8 +2997,11 @@ bool PrintOptions()
               << "    -r RecoOption          (required) [Full, AllHitsCR, AllHitsNu, CRRemHitsSliceCR, CRRemHitsSliceNu, AllHitsSliceCR, AllHitsSliceNu]"
               << std::endl
               << "    -i Settings            (required) [Run xml file for setting up the Pandora algorithms]" << std::endl
-              << "    -e EventsFile          (required) [Events input data ROOT file]" << std::endl
+              << "    -e EventsFile          (required) [Events input data ROOT file, unless given by each server job]" << std::endl
               << "    -g GeometryFile        (required) [ROOT file containing the TGeoManager geometry]" << std::endl
+              << "    -o GeometryCacheFile   (optional) [Cache of the TPC volumes found in GeometryFile, used instead of it and rebuilt when it changes]"
+              << std::endl
+              << "    -G                     (optional) [Only (re)build the GeometryCacheFile, without processing events]" << std::endl
               << "    -f DataFormat          (optional) [SP (SpacePoint default), SPMC (SpacePoint MC), EDepSim (rooTracker) or SED (LArSoft-like)]"
               << std::endl
               << "    -k EventsTreeName      (optional) [Name of the input events ROOT TTree (default = events)]" << std::endl
@@ -1873,12 +3014,35 @@ bool PrintOptions()
               << "    -n NEventsToProcess    (optional) [Number of events to process]" << std::endl
               << "    -s NEventsToSkip       (optional) [Number of events to skip in the event input file]" << std::endl
               << "    -p                     (optional) [Print status]" << std::endl
+              << "    -P nProcesses          (optional) [Fork nProcesses child processes after initialisation, sharing the events (default = 1)]"
+              << std::endl
+              << "    -B                     (optional) [Give each child process a block of events, instead of interleaving them (default = false)]"
+              << std::endl
+              << "    -S SpoolName           (optional) [Run as a server, processing \"EventsFile OutputFile\" jobs from a spool directory"
+              << " (*.job files) or control FIFO (lines), until a \"stop\" file or line. The EventsFile of each job replaces"
+              << " the hierarchy analysis EventFileName]" << std::endl
+              << "    -T ProfileFile         (optional) [Write the time of each worker event and LArProfiling daughter to this csv file,"
+              << " and print a summary at the end]" << std::endl
               << "    -N                     (optional) [Print event numbers]" << std::endl
               << "    -w width               (optional) [Voxel bin width (cm), default = 0.4 cm]" << std::endl
+              << "    -Z                     (optional) [Use Z-order (Morton) voxel IDs and create voxel hits in that order (default = false)]"
+              << std::endl
+              << "    -l maxCollinearRun     (optional) [Represent straight runs of up to maxCollinearRun voxels by their end voxels, default = 0 (off)]"
+              << std::endl
               << "    -m maxMergedVoxels     (optional) [Skip events that have N(space points) or N(merged voxels) > maxMergedVoxels (default = no events skipped)]"
               << std::endl
+              << "    -a maxCoarsening       (optional) [Instead of skipping events over maxMergedVoxels, use up to maxCoarsening coarser voxel levels (default = 0)]"
+              << std::endl
+              << "    -x pyramidFactor       (optional) [Voxel width ratio between each coarser voxel level and the one below, 2 to 4 (default = 2)]"
+              << std::endl
+              << "    -q projectionWidth     (optional) [Merge space point 2D hits within the same (wire, drift) cell of this width (cm), default = 0 (no merging)]"
+              << std::endl
               << "    -b minNSpacePoints     (optional) [Skip events that have N(space points) < minNSpacePoints (default < 2)]" << std::endl
               << "    -c minMipEquivE        (optional) [Minimum MIP equivalent energy, default = 0.3]" << std::endl
+              << "    -y subEventTimeGap     (optional) [Split each SP spill into sub-events at gaps in space point time of at least this, 0 = off]"
+              << std::endl
+              << "    -u minSubEventSPs      (optional) [Min number of space points of a sub-event, else it joins its nearest in time (default = 2)]"
+              << std::endl
               << std::endl;
 
     return false;
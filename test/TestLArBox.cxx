@@ -0,0 +1,137 @@
+/**
+ *  @file   LArRecoND/test/TestLArBox.cxx
+ *
+ *  @brief  Unit test of the batched ray/box intersection, which must match the single ray intersection bit for bit
+ *
+ *  $Log: $
+ */
+
+#include "LArBox.h"
+#include "LArGrid.h"
+#include "LArRay.h"
+
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace pandora;
+using namespace lar_nd_reco;
+
+/**
+ *  @brief  Intersect a list of rays with a box, one at a time and as a batch, and count the rays whose results differ
+ *
+ *  @param  box the box
+ *  @param  rays the rays
+ *  @param  testName the name of the test, for the printout
+ *
+ *  @return the number of rays whose batched results differ from the single ray results
+ */
+unsigned int CompareIntersections(const LArBox &box, const std::vector<LArRay> &rays, const std::string &testName);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+int main()
+{
+    const CartesianVector bottom(-10.f, -5.f, 0.f), top(10.f, 5.f, 30.f);
+    const LArGrid grid(bottom, top, CartesianVector(0.4f, 0.4f, 0.4f));
+    unsigned int nFailures(0);
+
+    // Axis-parallel rays, starting outside, on and inside the faces of the box, in both directions along each axis
+    const std::vector<CartesianVector> axisDirs{CartesianVector(1.f, 0.f, 0.f), CartesianVector(-1.f, 0.f, 0.f),
+        CartesianVector(0.f, 1.f, 0.f), CartesianVector(0.f, -1.f, 0.f), CartesianVector(0.f, 0.f, 1.f), CartesianVector(0.f, 0.f, -1.f)};
+    std::vector<LArRay> axisRays;
+
+    for (const float x : {-20.f, -10.f, 0.f, 10.f, 20.f})
+    {
+        for (const float y : {-5.f, 0.f, 5.f, 7.f})
+        {
+            for (const float z : {-1.f, 0.f, 15.f, 30.f})
+            {
+                for (const CartesianVector &dir : axisDirs)
+                    axisRays.emplace_back(CartesianVector(x, y, z), dir);
+            }
+        }
+    }
+
+    nFailures += CompareIntersections(grid, axisRays, "axis-parallel");
+
+    // Grazing rays, running along the faces and edges of the box, or touching it at a single corner
+    std::vector<LArRay> grazingRays;
+
+    for (int dx = -1; dx <= 1; ++dx)
+    {
+        for (int dy = -1; dy <= 1; ++dy)
+        {
+            for (int dz = -1; dz <= 1; ++dz)
+            {
+                if ((0 == dx) && (0 == dy) && (0 == dz))
+                    continue;
+
+                const CartesianVector dir(CartesianVector(dx, dy, dz).GetUnitVector());
+                for (const CartesianVector &corner : {bottom, top, CartesianVector(-10.f, 5.f, 0.f), CartesianVector(10.f, -5.f, 30.f)})
+                {
+                    grazingRays.emplace_back(corner, dir);
+                    grazingRays.emplace_back(corner - dir * 5., dir);
+                }
+            }
+        }
+    }
+
+    nFailures += CompareIntersections(grid, grazingRays, "grazing");
+
+    // Random rays, a third of which have no y component, in a number that is not a multiple of the batch lane count
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<float> uniform(-40.f, 40.f);
+    std::vector<LArRay> randomRays;
+
+    for (unsigned int iRay = 0; iRay < 10001; ++iRay)
+    {
+        const CartesianVector origin(uniform(generator), uniform(generator), uniform(generator));
+        const CartesianVector dir(uniform(generator), (iRay % 3) ? uniform(generator) : 0.f, uniform(generator));
+        randomRays.emplace_back(origin, dir.GetUnitVector());
+    }
+
+    nFailures += CompareIntersections(grid, randomRays, "random");
+
+    return (0 == nFailures) ? 0 : 1;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+unsigned int CompareIntersections(const LArBox &box, const std::vector<LArRay> &rays, const std::string &testName)
+{
+    LArRayBatch rayBatch;
+    rayBatch.Reserve(rays.size());
+
+    for (const LArRay &ray : rays)
+        rayBatch.AddRay(ray);
+
+    std::vector<double> t0, t1;
+    std::vector<int> isHit;
+    box.Intersect(rayBatch, t0, t1, isHit);
+
+    unsigned int nHits(0), nFailures(0);
+
+    for (size_t iRay = 0; iRay < rays.size(); ++iRay)
+    {
+        double rayT0(0.0), rayT1(0.0);
+        const bool isRayHit(box.Intersect(rays[iRay], rayT0, rayT1));
+
+        if (isRayHit)
+            ++nHits;
+
+        // Compare the bits, so that any difference in rounding or in the sign of a zero is caught
+        if ((isRayHit != static_cast<bool>(isHit[iRay])) || (0 != std::memcmp(&rayT0, &t0[iRay], sizeof(double))) ||
+            (0 != std::memcmp(&rayT1, &t1[iRay], sizeof(double))))
+        {
+            std::cout << "TestLArBox: " << testName << " ray " << iRay << " differs: single " << isRayHit << " " << rayT0 << " " << rayT1
+                      << ", batched " << isHit[iRay] << " " << t0[iRay] << " " << t1[iRay] << std::endl;
+            ++nFailures;
+        }
+    }
+
+    std::cout << "TestLArBox: " << testName << " rays " << rays.size() << ", hits " << nHits << ", differences " << nFailures << std::endl;
+    return nFailures;
+}